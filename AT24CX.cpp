@@ -27,6 +27,15 @@ THE SOFTWARE.
 #include "AT24CX.h"
 #include <Wire.h>
 
+// Wire buffer size, a write also sends two address bytes
+#if defined(I2C_BUFFER_LENGTH)
+#define AT24CX_WIRE_BUFFER I2C_BUFFER_LENGTH
+#elif defined(BUFFER_LENGTH)
+#define AT24CX_WIRE_BUFFER BUFFER_LENGTH
+#else
+#define AT24CX_WIRE_BUFFER 32
+#endif
+
 /**
  * Constructor with AT24Cx EEPROM at index 0
  */
@@ -107,29 +116,223 @@ AT24C512::AT24C512(byte index) {
 }
 
 /**
- * Init
+ * Backend with given transfer limits and write cycle
  */
-void AT24CX::init(byte index, byte pageSize) {
+AT24CX_Backend::AT24CX_Backend(int maxRead, int maxWrite, int pageSize, unsigned long writeCycle) {
+	this->maxRead = maxRead;
+	this->maxWrite = maxWrite;
+	this->pageSize = pageSize;
+	this->writeCycle = writeCycle;
+}
+
+/**
+ * Wait for the whole write cycle, backends able to tell when the chip is ready return earlier
+ */
+void AT24CX_Backend::waitReady(unsigned long ms) {
+	delay(ms);
+}
+
+/**
+ * I2C EEPROM at index 0
+ */
+AT24CX_I2C::AT24CX_I2C() : AT24CX_I2C(0, 32) {
+}
+
+/**
+ * I2C EEPROM at given index and size of page
+ */
+AT24CX_I2C::AT24CX_I2C(byte index, byte pageSize) : AT24CX_I2C(index, (int)pageSize, AT24CX_WRITE_CYCLE) {
+}
+
+AT24CX_I2C::AT24CX_I2C(byte index, int pageSize, unsigned long writeCycle) : AT24CX_Backend(AT24CX_WIRE_BUFFER, AT24CX_WIRE_BUFFER - 2, pageSize, writeCycle) {
 	_id = AT24CX_ID | (index & 0x7);
-	_pageSize = pageSize;
-	Wire.begin();
 }
 
+bool AT24CX_I2C::_begun = false;
+
 /**
- * Write byte
+ * Start Wire once, done by the first transfer. A sketch that starts Wire itself, e.g. to
+ * call Wire.setClock(), calls begin(true) afterwards so no transfer restarts Wire
  */
-void AT24CX::write(unsigned int address, byte data) {
+void AT24CX_I2C::begin(bool started) {
+	if (!_begun) {
+		if (!started)
+			Wire.begin();
+		_begun = true;
+	}
+}
+
+/**
+ * Write sequence of n bytes
+ */
+void AT24CX_I2C::write(unsigned int address, byte *data, int n) {
+	begin();
     Wire.beginTransmission(_id);
-    if(Wire.endTransmission()==0) {
-    	Wire.beginTransmission(_id);
+    if (Wire.endTransmission()==0) {
+     	Wire.beginTransmission(_id);
     	Wire.write(address >> 8);
     	Wire.write(address & 0xFF);
-      	Wire.write(data);
+    	Wire.write(data, n);
     	Wire.endTransmission();
-    	delay(20);
     }
 }
 
+/**
+ * Read sequence of n bytes
+ */
+void AT24CX_I2C::read(unsigned int address, byte *data, int n) {
+	begin();
+	Wire.beginTransmission(_id);
+    if (Wire.endTransmission()==0) {
+     	Wire.beginTransmission(_id);
+    	Wire.write(address >> 8);
+    	Wire.write(address & 0xFF);
+    	if (Wire.endTransmission()==0) {
+			int r = 0;
+    		Wire.requestFrom(_id, n);
+			while (Wire.available() > 0 && r<n) {
+				data[r] = (byte)Wire.read();
+				r++;
+			}
+    	}
+    }
+}
+
+/**
+ * I2C FRAM at given index
+ */
+AT24CX_FRAM::AT24CX_FRAM(byte index) : AT24CX_I2C(index, 0, 0) {
+}
+
+/**
+ * RAM buffer of given size
+ */
+AT24CX_RAM::AT24CX_RAM(byte *buffer, unsigned int size, int pageSize, unsigned long writeCycle)
+	: AT24CX_Backend(size, size, pageSize, writeCycle) {
+	_buffer = buffer;
+	_size = size;
+}
+
+/**
+ * Write sequence of n bytes
+ */
+void AT24CX_RAM::write(unsigned int address, byte *data, int n) {
+	for (int i = 0; i < n; i++)
+		_buffer[(address + i) % _size] = data[i];
+}
+
+/**
+ * Read sequence of n bytes
+ */
+void AT24CX_RAM::read(unsigned int address, byte *data, int n) {
+	for (int i = 0; i < n; i++)
+		data[i] = _buffer[(address + i) % _size];
+}
+
+bool AT24CX::_busy[8];
+unsigned long AT24CX::_writeStart[8];
+
+/**
+ * Init
+ */
+void AT24CX::init(byte index, byte pageSize) {
+	_id = AT24CX_ID | (index & 0x7);
+	_deferred = false;
+	_i2c = AT24CX_I2C(index, pageSize);
+	_backend = &_i2c;
+}
+
+/**
+ * Copy, a copy of an object on its own I2C EEPROM uses its own copy of that backend
+ */
+AT24CX::AT24CX(const AT24CX &other) {
+	*this = other;
+}
+
+AT24CX &AT24CX::operator=(const AT24CX &other) {
+	_id = other._id;
+	memcpy(_b, other._b, sizeof(_b));
+	_deferred = other._deferred;
+	_i2c = other._i2c;
+	_backend = other._backend == &other._i2c ? &_i2c : other._backend;
+	return *this;
+}
+
+/**
+ * Read and write through another backend, NULL means the I2C EEPROM given to the constructor
+ */
+void AT24CX::setBackend(AT24CX_Backend *backend) {
+	sync();
+	_backend = backend ? backend : &_i2c;
+}
+
+/**
+ * Return from writes without waiting for the write cycle.
+ * The wait is done by sync() or by the next access to the same chip,
+ * so writes to other chips can overlap the write cycle.
+ */
+void AT24CX::setDeferredWrite(bool deferred) {
+	_deferred = deferred;
+	if (!deferred)
+		sync();
+}
+
+/**
+ * Page size of backend, 0 means writes may cross pages
+ */
+int AT24CX::pageSize() {
+	return _backend->pageSize;
+}
+
+/**
+ * Largest write transfer of backend, longer writes are split
+ */
+int AT24CX::maxWrite() {
+	return _backend->maxWrite;
+}
+
+/**
+ * Wait until the last write cycle of this chip is over
+ */
+void AT24CX::sync() {
+	int dev = _id & 0x7;
+	unsigned long cycle = _backend->writeCycle;
+	if (cycle > 0 && _busy[dev]) {
+		unsigned long elapsed = millis() - _writeStart[dev];
+		if (elapsed < cycle)
+			_backend->waitReady(cycle - elapsed);
+		_busy[dev] = false;
+	}
+}
+
+/**
+ * Check without waiting whether the last write cycle of this chip is over
+ */
+bool AT24CX::ready() {
+	int dev = _id & 0x7;
+	if (_busy[dev] && millis() - _writeStart[dev] >= _backend->writeCycle)
+		_busy[dev] = false;
+	return !_busy[dev];
+}
+
+/**
+ * Mark start of write cycle
+ */
+void AT24CX::writeStarted() {
+	int dev = _id & 0x7;
+	if (_backend->writeCycle == 0)
+		return;
+	_busy[dev] = true;
+	_writeStart[dev] = millis();
+}
+
+/**
+ * Write byte
+ */
+void AT24CX::write(unsigned int address, byte data) {
+	write(address, &data, 1);
+}
+
 /**
  * Write integer
  */
@@ -211,36 +414,44 @@ void AT24CX::write(unsigned int address, byte *data, int n) {
 	// status quo
 	int c = n;						// bytes left to write
 	int offD = 0;					// current offset in data pointer
-	int offP;						// current offset in page
 	int nc = 0;						// next n bytes to write
 
 	// write alle bytes in multiple steps
 	while (c > 0) {
-		// calc offset in page
-		offP = address % _pageSize;
-		// maximal 30 bytes to write
-		nc = min(min(c, 30), _pageSize - offP);
-		write(address, data, offD, nc);
+		nc = writeStep(address, data+offD, c);
 		c-=nc;
 		offD+=nc;
 		address+=nc;
 	}
+	// wait for the last write cycle unless writes are deferred
+	if (!_deferred)
+		sync();
+}
+
+/**
+ * Write the first bus transfer of n bytes. The write cycle is started, not waited for.
+ * Returns the number of bytes written
+ */
+int AT24CX::writeStep(unsigned int address, byte *data, int n) {
+	int offP;						// current offset in page
+	// maximal transfer size of backend
+	int nc = min(n, _backend->maxWrite);
+	// calc offset in page
+	if (_backend->pageSize > 0) {
+		offP = address % _backend->pageSize;
+		nc = min(nc, _backend->pageSize - offP);
+	}
+	write(address, data, 0, nc);
+	return nc;
 }
 
 /**
  * Write sequence of n bytes from offset
  */
 void AT24CX::write(unsigned int address, byte *data, int offset, int n) {
-    Wire.beginTransmission(_id);
-    if (Wire.endTransmission()==0) {
-     	Wire.beginTransmission(_id);
-    	Wire.write(address >> 8);
-    	Wire.write(address & 0xFF);
-    	byte *adr = data+offset;
-    	Wire.write(adr, n);
-    	Wire.endTransmission();
-    	delay(20);
-    }
+	sync();
+	_backend->write(address, data+offset, n);
+	writeStarted();
 }
 
 /**
@@ -248,21 +459,8 @@ void AT24CX::write(unsigned int address, byte *data, int offset, int n) {
  */
 byte AT24CX::read(unsigned int address) {
 	byte b = 0;
-	int r = 0;
-	Wire.beginTransmission(_id);
-    if (Wire.endTransmission()==0) {
-     	Wire.beginTransmission(_id);
-    	Wire.write(address >> 8);
-    	Wire.write(address & 0xFF);
-    	if (Wire.endTransmission()==0) {
-			Wire.requestFrom(_id, 1);
-			while (Wire.available() > 0 && r<1) {
-				b = (byte)Wire.read();
-				r++;
-			}
-    	}
-    }
-    return b;
+	readStep(address, &b, 1);
+	return b;
 }
 
 /**
@@ -273,35 +471,32 @@ void AT24CX::read(unsigned int address, byte *data, int n) {
 	int offD = 0;
 	// read until are n bytes read
 	while (c > 0) {
-		// read maximal 32 bytes
-		int nc = c;
-		if (nc > 32)
-			nc = 32;
-		read(address, data, offD, nc);
+		int nc = readStep(address, data+offD, c);
 		address+=nc;
 		offD+=nc;
 		c-=nc;
 	}
 }
 
+/**
+ * Read the first bus transfer of n bytes.
+ * Returns the number of bytes read
+ */
+int AT24CX::readStep(unsigned int address, byte *data, int n) {
+	// read maximal transfer size of backend
+	int nc = n;
+	if (nc > _backend->maxRead)
+		nc = _backend->maxRead;
+	read(address, data, 0, nc);
+	return nc;
+}
+
 
 /**
  * Read sequence of n bytes to offset
  */
 void AT24CX::read(unsigned int address, byte *data, int offset, int n) {
-	Wire.beginTransmission(_id);
-    if (Wire.endTransmission()==0) {
-     	Wire.beginTransmission(_id);
-    	Wire.write(address >> 8);
-    	Wire.write(address & 0xFF);
-    	if (Wire.endTransmission()==0) {
-			int r = 0;
-    		Wire.requestFrom(_id, n);
-			while (Wire.available() > 0 && r<n) {
-				data[offset+r] = (byte)Wire.read();
-				r++;
-			}
-    	}
-    }
+	sync();
+	_backend->read(address, data+offset, n);
 }
 
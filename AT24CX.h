@@ -38,11 +38,67 @@ typedef uint8_t byte;
 // 0x50
 #define AT24CX_ID B1010000
 
+// write cycle time in ms, waited after each page write
+#define AT24CX_WRITE_CYCLE 20
+
+// storage backend, AT24CX reads and writes through it
+class AT24CX_Backend {
+public:
+	virtual ~AT24CX_Backend() {}
+	// read n bytes, n is at most maxRead
+	virtual void read(unsigned int address, byte *data, int n) = 0;
+	// write n bytes, n is at most maxWrite and never crosses a page
+	virtual void write(unsigned int address, byte *data, int n) = 0;
+	// wait for the end of a write cycle, at most ms milliseconds
+	virtual void waitReady(unsigned long ms);
+	int maxRead;				// largest read transfer, in bytes
+	int maxWrite;				// largest write transfer, in bytes
+	int pageSize;				// page size, 0 means writes may cross pages
+	unsigned long writeCycle;	// time in ms waited after each write, 0 means none
+protected:
+	AT24CX_Backend(int maxRead, int maxWrite, int pageSize, unsigned long writeCycle);
+};
+
+// I2C EEPROM on Wire, default backend. Wire is started by the first transfer, so objects moved to
+// another backend before any access never touch it
+class AT24CX_I2C : public AT24CX_Backend {
+public:
+	AT24CX_I2C();
+	AT24CX_I2C(byte index, byte pageSize);
+	void read(unsigned int address, byte *data, int n);
+	void write(unsigned int address, byte *data, int n);
+	static void begin(bool started = false);
+protected:
+	AT24CX_I2C(byte index, int pageSize, unsigned long writeCycle);
+private:
+	int _id;
+	static bool _begun;
+};
+
+// I2C FRAM on Wire (FM24Cxx, MB85RCxx), no write cycle and no page limit
+class AT24CX_FRAM : public AT24CX_I2C {
+public:
+	AT24CX_FRAM(byte index);
+};
+
+// RAM buffer, addresses wrap at its size
+class AT24CX_RAM : public AT24CX_Backend {
+public:
+	AT24CX_RAM(byte *buffer, unsigned int size, int pageSize = 0, unsigned long writeCycle = 0);
+	void read(unsigned int address, byte *data, int n);
+	void write(unsigned int address, byte *data, int n);
+private:
+	byte *_buffer;
+	unsigned int _size;
+};
+
 // general class definition
 class AT24CX {
 public:
 	AT24CX();
 	AT24CX(byte index, byte pageSize);
+	AT24CX(const AT24CX &other);
+	AT24CX &operator=(const AT24CX &other);
 	void write(unsigned int address, byte data);
 	void write(unsigned int address, byte *data, int n);
 	void writeInt(unsigned int address, unsigned int data);
@@ -57,14 +113,28 @@ public:
 	float readFloat(unsigned int address);
 	double readDouble(unsigned int address);
 	void readChars(unsigned int address, char *data, int n);
+	void setDeferredWrite(bool deferred);
+	void sync();
+	void setBackend(AT24CX_Backend *backend);
+	int pageSize();
+	int maxWrite();
+	bool ready();
+	int writeStep(unsigned int address, byte *data, int n);
+	int readStep(unsigned int address, byte *data, int n);
 protected:
 	void init(byte index, byte pageSize);
 private:
 	void read(unsigned int address, byte *data, int offset, int n);
 	void write(unsigned int address, byte *data, int offset, int n);
+	void writeStarted();
 	int _id;
 	byte _b[8];
-	byte _pageSize;
+	bool _deferred;
+	AT24CX_I2C _i2c;
+	AT24CX_Backend *_backend;
+	// write cycle state is per device, shared by all objects on the same chip
+	static bool _busy[8];
+	static unsigned long _writeStart[8];
 };
 
 // AT24C32 class definiton
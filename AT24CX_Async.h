@@ -0,0 +1,154 @@
+/**
+ * @file AT24CX_Async.h
+ * @brief Non-blocking reads, writes and wipes for cooperative loop() scheduling
+ *
+ * Operations are queued on an AT24CX_Async and run in order by poll(), which does at most one bus
+ * transfer per call and never waits: while the chip is in its write cycle poll() returns at once.
+ * Completion is signalled by AT24CX_Op::done and the optional callback, called from poll().
+ *
+ * Addresses are absolute, one AT24CX_Async serves every object on its chip, e.g. all rings chained
+ * with get_end_addr(). Blocking calls to the same chip must not run while operations are queued.
+ */
+#ifndef AT24CX_Async_h
+#define AT24CX_Async_h
+
+#include "AT24CX.h"
+
+// bytes of the fill pattern buffer, a wipe writes at most this much per transfer
+#define AT24CX_ASYNC_FILL 64
+
+// queued operation, owned by the caller and kept alive until done is set
+struct AT24CX_Op {
+	bool done = true;								// set when the operation is complete
+	void (*callback)(AT24CX_Op *op, void *ctx) = NULL;	// optional, called from poll() when done
+	void *ctx = NULL;
+
+	// state, used by AT24CX_Async
+	enum Type { READ, WRITE, FILL };
+	Type type = WRITE;
+	unsigned int address = 0;
+	byte *data = NULL;
+	int left = 0;
+	byte fill = 0;
+	AT24CX_Op *next = NULL;
+};
+
+class AT24CX_Async {
+public:
+	AT24CX_Async(AT24CX &chip) : _chip(chip) {
+	}
+
+	/**
+	 * Queue write of n bytes, data must stay valid until done
+	 */
+	AT24CX_Op *write(AT24CX_Op &op, unsigned int address, byte *data, int n) {
+		return start(op, AT24CX_Op::WRITE, address, data, n, 0);
+	}
+
+	/**
+	 * Queue read of n bytes into data
+	 */
+	AT24CX_Op *read(AT24CX_Op &op, unsigned int address, byte *data, int n) {
+		return start(op, AT24CX_Op::READ, address, data, n, 0);
+	}
+
+	/**
+	 * Queue erase of n bytes to 0xFF. A wiped ring needs wl_init() again
+	 */
+	AT24CX_Op *wipe(AT24CX_Op &op, unsigned int address, int n) {
+		return start(op, AT24CX_Op::FILL, address, NULL, n, 0xFF);
+	}
+
+	/**
+	 * Do at most one bus transfer of the oldest operation, call from loop().
+	 * Returns true while operations are queued
+	 */
+	bool poll() {
+		AT24CX_Op *op = _head;
+		if (op == NULL)
+			return false;
+		// write cycle of previous transfer is not over, come back later
+		if (!_chip.ready())
+			return true;
+
+		int n;
+		if (op->type == AT24CX_Op::READ) {
+			n = _chip.readStep(op->address, op->data, op->left);
+			op->data += n;
+		} else if (op->type == AT24CX_Op::WRITE) {
+			n = _chip.writeStep(op->address, op->data, op->left);
+			op->data += n;
+		} else {
+			byte pattern[AT24CX_ASYNC_FILL];
+			n = min(op->left, AT24CX_ASYNC_FILL);
+			memset(pattern, op->fill, n);
+			n = _chip.writeStep(op->address, pattern, n);
+		}
+		op->address += n;
+		op->left -= n;
+
+		if (op->left == 0)
+			finish();
+		return _head != NULL;
+	}
+
+	/**
+	 * Operations queued or running
+	 */
+	bool busy() {
+		return _head != NULL;
+	}
+
+	/**
+	 * Run queued operations to the end, blocking
+	 */
+	void wait() {
+		while (poll())
+			_chip.sync();
+		_chip.sync();
+	}
+
+private:
+	AT24CX &_chip;
+	AT24CX_Op *_head = NULL;
+	AT24CX_Op *_tail = NULL;
+
+	AT24CX_Op *start(AT24CX_Op &op, AT24CX_Op::Type type, unsigned int address, byte *data, int n, byte fill) {
+		assert(op.done); // op is still queued
+
+		op.type = type;
+		op.address = address;
+		op.data = data;
+		op.left = n;
+		op.fill = fill;
+		op.next = NULL;
+		if (n <= 0) {
+			complete(&op);
+			return &op;
+		}
+
+		op.done = false;
+		if (_tail != NULL)
+			_tail->next = &op;
+		else
+			_head = &op;
+		_tail = &op;
+		return &op;
+	}
+
+	void finish() {
+		AT24CX_Op *op = _head;
+		_head = op->next;
+		if (_head == NULL)
+			_tail = NULL;
+		complete(op);
+	}
+
+	static void complete(AT24CX_Op *op) {
+		op->done = true;
+		if (op->callback != NULL)
+			op->callback(op, op->ctx);
+	}
+};
+
+#endif
@@ -0,0 +1,160 @@
+/**
+ * @file AT24CX_File.h
+ * @brief AT24CX backends on a host file holding a raw EEPROM image
+ *
+ * AT24CX_File needs stdio file access, AT24CX_MMap needs a POSIX mmap(), both are meant for host
+ * builds and chip images. Addresses wrap at the image size like the chip address counter.
+ * Set them with AT24CX::setBackend() before init.
+ */
+#ifndef AT24CX_File_h
+#define AT24CX_File_h
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "AT24CX.h"
+
+// raw EEPROM image in a file
+class AT24CX_File : public AT24CX_Backend {
+public:
+	// open image, a missing or short file is extended with erased bytes (0xFF)
+	AT24CX_File(const char *path, unsigned int size, int pageSize = 0, unsigned long writeCycle = 0)
+		: AT24CX_Backend(size, size, pageSize, writeCycle) {
+		_size = size;
+		_file = fopen(path, "r+b");
+		if (_file == NULL)
+			_file = fopen(path, "w+b");
+		assert(_file != NULL);
+
+		fseek(_file, 0, SEEK_END);
+		long length = ftell(_file);
+		for (long i = length; i < (long)size; i++)
+			fputc(0xFF, _file);
+		fflush(_file);
+	}
+
+	~AT24CX_File() {
+		fclose(_file);
+	}
+
+	AT24CX_File(const AT24CX_File &) = delete;
+	AT24CX_File &operator=(const AT24CX_File &) = delete;
+
+	void read(unsigned int address, byte *data, int n) {
+		address %= _size;
+		int first = min<int>(n, _size - address);
+		fseek(_file, address, SEEK_SET);
+		fread(data, 1, first, _file);
+		if (first < n) {
+			fseek(_file, 0, SEEK_SET);
+			fread(data + first, 1, n - first, _file);
+		}
+	}
+
+	void write(unsigned int address, byte *data, int n) {
+		address %= _size;
+		int first = min<int>(n, _size - address);
+		fseek(_file, address, SEEK_SET);
+		fwrite(data, 1, first, _file);
+		if (first < n) {
+			fseek(_file, 0, SEEK_SET);
+			fwrite(data + first, 1, n - first, _file);
+		}
+		fflush(_file); // image stays consistent if the host process dies
+	}
+
+private:
+	FILE *_file;
+	unsigned int _size;
+};
+
+// raw EEPROM image mapped in memory, reads and writes are plain copies to and from the mapping
+class AT24CX_MMap : public AT24CX_Backend {
+public:
+	// map image, a missing or short file is extended with erased bytes (0xFF).
+	// A read-only image is mapped private: writes change the mapping only, the file is kept as it is
+	AT24CX_MMap(const char *path, unsigned int size, int pageSize = 0, bool writable = true, unsigned long writeCycle = 0)
+		: AT24CX_Backend(size, size, pageSize, writeCycle) {
+		_size = size;
+		int fd = open(path, writable ? O_RDWR | O_CREAT : O_RDONLY, 0644);
+		assert(fd >= 0);
+
+		struct stat st;
+		fstat(fd, &st);
+		if (writable && st.st_size < (off_t)size) {
+			byte erased[256];
+			memset(erased, 0xFF, sizeof(erased));
+			lseek(fd, st.st_size, SEEK_SET);
+			for (off_t left = size - st.st_size; left > 0; left -= sizeof(erased)) {
+				ssize_t written = ::write(fd, erased, min<off_t>(left, sizeof(erased)));
+				assert(written > 0);
+				(void)written;
+			}
+		}
+		// a short read-only image reads as erased past its end
+		off_t mapped = min<off_t>(st.st_size, size);
+
+		_image = (byte *)mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		assert(_image != MAP_FAILED);
+		if (writable || mapped == (off_t)size) {
+			void *file = mmap(_image, size, PROT_READ | PROT_WRITE, (writable ? MAP_SHARED : MAP_PRIVATE) | MAP_FIXED, fd, 0);
+			assert(file != MAP_FAILED);
+			(void)file;
+		} else {
+			memset(_image, 0xFF, size);
+			ssize_t got = pread(fd, _image, mapped, 0);
+			assert(got == mapped);
+			(void)got;
+		}
+		close(fd);
+	}
+
+	~AT24CX_MMap() {
+		munmap(_image, _size);
+	}
+
+	AT24CX_MMap(const AT24CX_MMap &) = delete;
+	AT24CX_MMap &operator=(const AT24CX_MMap &) = delete;
+
+	// image bytes, for direct access without going through AT24CX
+	byte *image() {
+		return _image;
+	}
+
+	void read(unsigned int address, byte *data, int n) {
+		address %= _size;
+		int first = min<int>(n, _size - address);
+		memcpy(data, _image + address, first);
+		memcpy(data + first, _image, n - first);
+	}
+
+	// bytes past the end of a page wrap to its start, like the chip
+	void write(unsigned int address, byte *data, int n) {
+		address %= _size;
+		bool inPage = pageSize == 0 || address % pageSize + n <= (unsigned int)pageSize;
+		if (inPage && address + n <= _size) {
+			memcpy(_image + address, data, n);
+			return;
+		}
+		for (int i = 0; i < n; i++) {
+			unsigned int a = address + i;
+			if (pageSize > 0)
+				a = address - address % pageSize + (address % pageSize + i) % pageSize;
+			_image[a % _size] = data[i];
+		}
+	}
+
+	// write the mapping back to the file now
+	void sync() {
+		msync(_image, _size, MS_SYNC);
+	}
+
+private:
+	byte *_image;
+	unsigned int _size;
+};
+
+#endif
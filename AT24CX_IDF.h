@@ -0,0 +1,98 @@
+/**
+ * @file AT24CX_IDF.h
+ * @brief AT24CX backend on the ESP-IDF I2C master driver, bypassing Wire
+ *
+ * Each read or write is one command link executed by i2c_master_cmd_begin(). Data goes straight
+ * from and to the caller's buffer, a read covers up to AT24CX_IDF_MAX_READ bytes and a write a whole
+ * page. The driver enforces the transfer timeout. The write cycle ends as soon as the chip ACKs its
+ * address again (ACK polling), AT24CX_WRITE_CYCLE is only the upper limit.
+ *
+ * The I2C driver must be installed by the caller with i2c_param_config() and i2c_driver_install().
+ * Set the backend with AT24CX::setBackend() before init. Wire is only started by a transfer through
+ * the default AT24CX_I2C backend, so it never claims the port here. On a host, extras/host/driver/i2c.h
+ * fakes the driver on the simulated bus, add extras/host/i2c.cpp to the build.
+ */
+#ifndef AT24CX_IDF_h
+#define AT24CX_IDF_h
+
+#include <driver/i2c.h>
+
+#include "AT24CX.h"
+
+// largest read transfer, in bytes
+#define AT24CX_IDF_MAX_READ 4096
+
+// I2C EEPROM on an ESP-IDF I2C port
+class AT24CX_IDF : public AT24CX_Backend {
+public:
+	AT24CX_IDF(i2c_port_t port, byte index, int pageSize, int timeoutMs = 50)
+		: AT24CX_Backend(AT24CX_IDF_MAX_READ, pageSize > 0 ? pageSize : AT24CX_IDF_MAX_READ, pageSize, AT24CX_WRITE_CYCLE) {
+		_port = port;
+		_id = AT24CX_ID | (index & 0x7);
+		_timeoutMs = timeoutMs;
+	}
+
+	void read(unsigned int address, byte *data, int n) {
+		uint8_t link[I2C_LINK_RECOMMENDED_SIZE(2)];
+		byte head[2] = {(byte)(address >> 8), (byte)(address & 0xFF)};
+
+		// address write, repeated start, sequential read
+		i2c_cmd_handle_t cmd = i2c_cmd_link_create_static(link, sizeof(link));
+		i2c_master_start(cmd);
+		i2c_master_write_byte(cmd, (_id << 1) | I2C_MASTER_WRITE, true);
+		i2c_master_write(cmd, head, 2, true);
+		i2c_master_start(cmd);
+		i2c_master_write_byte(cmd, (_id << 1) | I2C_MASTER_READ, true);
+		i2c_master_read(cmd, data, n, I2C_MASTER_LAST_NACK);
+		i2c_master_stop(cmd);
+		esp_err_t err = i2c_master_cmd_begin(_port, cmd, pdMS_TO_TICKS(_timeoutMs));
+		i2c_cmd_link_delete_static(cmd);
+
+		if (err != ESP_OK)
+			ESP_LOGW("AT24CX", "Read of %d bytes at %u failed: %s", n, address, esp_err_to_name(err));
+	}
+
+	void write(unsigned int address, byte *data, int n) {
+		uint8_t link[I2C_LINK_RECOMMENDED_SIZE(1)];
+		byte head[2] = {(byte)(address >> 8), (byte)(address & 0xFF)};
+
+		i2c_cmd_handle_t cmd = i2c_cmd_link_create_static(link, sizeof(link));
+		i2c_master_start(cmd);
+		i2c_master_write_byte(cmd, (_id << 1) | I2C_MASTER_WRITE, true);
+		i2c_master_write(cmd, head, 2, true);
+		i2c_master_write(cmd, data, n, true);
+		i2c_master_stop(cmd);
+		esp_err_t err = i2c_master_cmd_begin(_port, cmd, pdMS_TO_TICKS(_timeoutMs));
+		i2c_cmd_link_delete_static(cmd);
+
+		if (err != ESP_OK)
+			ESP_LOGW("AT24CX", "Write of %d bytes at %u failed: %s", n, address, esp_err_to_name(err));
+	}
+
+	// ACK polling, the chip NACKs its address until the write cycle is over
+	void waitReady(unsigned long ms) {
+		unsigned long start = millis();
+		while (!probe()) {
+			if (millis() - start >= ms)
+				return;
+		}
+	}
+
+private:
+	i2c_port_t _port;
+	int _id;
+	int _timeoutMs;
+
+	bool probe() {
+		uint8_t link[I2C_LINK_RECOMMENDED_SIZE(1)];
+		i2c_cmd_handle_t cmd = i2c_cmd_link_create_static(link, sizeof(link));
+		i2c_master_start(cmd);
+		i2c_master_write_byte(cmd, (_id << 1) | I2C_MASTER_WRITE, true);
+		i2c_master_stop(cmd);
+		esp_err_t err = i2c_master_cmd_begin(_port, cmd, pdMS_TO_TICKS(_timeoutMs));
+		i2c_cmd_link_delete_static(cmd);
+		return err == ESP_OK;
+	}
+};
+
+#endif
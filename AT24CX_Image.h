@@ -0,0 +1,201 @@
+/**
+ * @file AT24CX_Image.h
+ * @brief Binary dump and restore of a chip region over a Stream (Serial)
+ *
+ * The image is sent as frames: sync byte 0xA5, type, address (4 bytes), length (2 bytes), payload and
+ * CRC-16/CCITT (poly 0x1021, init 0xFFFF) over everything after the sync byte. Numbers are little endian.
+ * Frame types: 'H' header (payload is the image size), 'D' data (at most AT24CX_IMAGE_FRAME bytes),
+ * 'E' end (payload is the CRC-32 of all data bytes, same as zlib crc32).
+ *
+ * Bus and serial work overlap: the next block is read while the UART drains its buffer on dump,
+ * and the write cycle of the last page of a restored block runs while the next frame is received.
+ * Pages inside a block are written one write cycle apart.
+ */
+#ifndef AT24CX_Image_h
+#define AT24CX_Image_h
+
+#include "AT24CX.h"
+
+// data bytes per frame
+#define AT24CX_IMAGE_FRAME 256
+
+// restore status
+enum AT24CX_ImageStatus {
+	AT24CX_IMAGE_OK = 0,
+	AT24CX_IMAGE_TIMEOUT,	// stream ended inside a frame
+	AT24CX_IMAGE_CRC,		// frame crc mismatch
+	AT24CX_IMAGE_FORMAT,	// unexpected frame type, address or length
+	AT24CX_IMAGE_CHECKSUM	// image crc mismatch, data was written
+};
+
+class AT24CX_Image {
+public:
+	AT24CX_Image(AT24CX &chip, Stream &stream) : _chip(chip), _stream(stream) {
+	}
+
+	/**
+	 * Send size bytes from address
+	 */
+	void dump(unsigned long address, unsigned long size) {
+		byte data[AT24CX_IMAGE_FRAME];
+		unsigned long crc = 0xFFFFFFFF;
+
+		putLong(data, size);
+		sendFrame('H', address, data, 4);
+		for (unsigned long off = 0; off < size; off += AT24CX_IMAGE_FRAME) {
+			int n = min<unsigned long>(AT24CX_IMAGE_FRAME, size - off);
+			// largest bus transfers, write() returns once the frame fits in the UART buffer
+			_chip.read(address + off, data, n);
+			crc = crc32(crc, data, n);
+			sendFrame('D', address + off, data, n);
+		}
+		putLong(data, ~crc);
+		sendFrame('E', address, data, 4);
+		_stream.flush();
+	}
+
+	/**
+	 * Receive an image and write it to the address it was dumped from.
+	 * Pages that already hold the received bytes are not written when skipIdentical is set, the
+	 * block is read once before its first page is written so no read waits for a write cycle of it.
+	 * Writes are deferred while receiving, deferred writes are off when it returns
+	 */
+	AT24CX_ImageStatus restore(bool skipIdentical = true) {
+		byte data[AT24CX_IMAGE_FRAME];
+		char type;
+		unsigned long address, next = 0, end = 0;
+		unsigned long crc = 0xFFFFFFFF;
+		int n;
+		bool started = false;
+		AT24CX_ImageStatus status;
+
+		_written = 0;
+		_chip.setDeferredWrite(true);
+		for (;;) {
+			status = receiveFrame(type, address, data, n);
+			if (status != AT24CX_IMAGE_OK)
+				break;
+
+			if (type == 'H' && !started && n == 4) {
+				started = true;
+				next = address;
+				end = address + getLong(data);
+			} else if (type == 'D' && started && address == next && address + n <= end) {
+				crc = crc32(crc, data, n);
+				writeBlock(address, data, n, skipIdentical);
+				next += n;
+			} else if (type == 'E' && started && next == end && n == 4) {
+				status = getLong(data) == (~crc & 0xFFFFFFFF) ? AT24CX_IMAGE_OK : AT24CX_IMAGE_CHECKSUM;
+				break;
+			} else {
+				status = AT24CX_IMAGE_FORMAT;
+				break;
+			}
+		}
+		_chip.setDeferredWrite(false);
+		return status;
+	}
+
+	/**
+	 * Bytes written by the last restore, skipped pages are not counted
+	 */
+	unsigned long written() {
+		return _written;
+	}
+
+private:
+	AT24CX &_chip;
+	Stream &_stream;
+	unsigned long _written = 0;
+
+	void sendFrame(char type, unsigned long address, const byte *data, int n) {
+		byte head[8];
+		head[0] = 0xA5;
+		head[1] = type;
+		putLong(head + 2, address);
+		head[6] = n & 0xFF;
+		head[7] = n >> 8;
+		unsigned int crc = crc16(0xFFFF, head + 1, 7);
+		crc = crc16(crc, data, n);
+		byte tail[2] = {(byte)(crc & 0xFF), (byte)(crc >> 8)};
+
+		_stream.write(head, 8);
+		_stream.write(data, n);
+		_stream.write(tail, 2);
+	}
+
+	AT24CX_ImageStatus receiveFrame(char &type, unsigned long &address, byte *data, int &n) {
+		byte head[7], tail[2], sync = 0;
+		// skip noise before the sync byte
+		do {
+			if (_stream.readBytes(&sync, 1) != 1)
+				return AT24CX_IMAGE_TIMEOUT;
+		} while (sync != 0xA5);
+
+		if (_stream.readBytes(head, 7) != 7)
+			return AT24CX_IMAGE_TIMEOUT;
+		type = head[0];
+		address = getLong(head + 1);
+		n = head[5] | (head[6] << 8);
+		if (n > AT24CX_IMAGE_FRAME)
+			return AT24CX_IMAGE_FORMAT;
+		if (_stream.readBytes(data, n) != (size_t)n || _stream.readBytes(tail, 2) != 2)
+			return AT24CX_IMAGE_TIMEOUT;
+
+		unsigned int crc = crc16(0xFFFF, head, 7);
+		crc = crc16(crc, data, n);
+		if ((uint16_t)(tail[0] | (tail[1] << 8)) != crc)
+			return AT24CX_IMAGE_CRC;
+		return AT24CX_IMAGE_OK;
+	}
+
+	// write block a page at a time, AT24CX::write() merges each page into the largest bus transfers
+	void writeBlock(unsigned long address, byte *data, int n, bool skipIdentical) {
+		byte old[AT24CX_IMAGE_FRAME];
+		const byte *page = old;
+		int pageSize = _chip.pageSize();
+		if (skipIdentical)
+			_chip.read(address, old, n); // waits only for the last write cycle of the previous block
+		while (n > 0) {
+			int nc = pageSize > 0 ? min<int>(n, pageSize - address % pageSize) : n;
+			if (!skipIdentical || memcmp(page, data, nc) != 0) {
+				_chip.write(address, data, nc);
+				_written += nc;
+			}
+			address += nc;
+			data += nc;
+			page += nc;
+			n -= nc;
+		}
+	}
+
+	static void putLong(byte *out, unsigned long value) {
+		for (int i = 0; i < 4; i++)
+			out[i] = (value >> (8 * i)) & 0xFF;
+	}
+
+	static unsigned long getLong(const byte *in) {
+		return (unsigned long)in[0] | ((unsigned long)in[1] << 8) | ((unsigned long)in[2] << 16) | ((unsigned long)in[3] << 24);
+	}
+
+	static unsigned int crc16(unsigned int crc, const byte *data, int n) {
+		for (int i = 0; i < n; i++) {
+			crc ^= (unsigned int)data[i] << 8;
+			for (int bit = 0; bit < 8; bit++)
+				crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1);
+			crc &= 0xFFFF;
+		}
+		return crc;
+	}
+
+	static unsigned long crc32(unsigned long crc, const byte *data, int n) {
+		for (int i = 0; i < n; i++) {
+			crc ^= data[i];
+			for (int bit = 0; bit < 8; bit++)
+				crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320 : (crc >> 1);
+		}
+		return crc & 0xFFFFFFFF;
+	}
+};
+
+#endif
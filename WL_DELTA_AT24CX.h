@@ -0,0 +1,313 @@
+/**
+ * @file WL_DELTA_AT24CX.h
+ * @brief Delta-encoded time series on a wear-leveled AT24CX ring
+ *
+ * Each ring record is a block holding a keyframe value and up to deltas_per_record signed deltas,
+ * each delta relative to the sample before it. Samples are staged in RAM until the block is full,
+ * a delta does not fit in delta_t, the block is older than wl_delta_max_age(), or flush() is called.
+ * Blocks are stored with WL_AT24CX, which keeps its pointer, crc and head recovery.
+ *
+ * The open block lives in RAM only: a reset loses its samples, at most deltas_per_record + 1 of them
+ * and at most max_age_ms worth when a max age is set. The destructor flushes it, and so does
+ * wl_power_fail_commit() once wl_power_fail_register() is called.
+ */
+#ifndef WL_DELTA_AT24CX_h
+#define WL_DELTA_AT24CX_h
+
+#include "WL_AT24CX.h"
+
+#include <cmath>
+#include <type_traits>
+
+template <class data_t, class delta_t, size_t deltas_per_record>
+struct wl_delta_block_t {
+    data_t base;   // keyframe, first sample of the block
+    uint8_t count; // number of valid deltas
+    delta_t delta[deltas_per_record];
+} __attribute__((packed)); // packed to ensure sizeof returns correct struct size
+
+/**
+ * @brief Delta-encoded EEPROM ring for numeric data
+ *
+ * @tparam data_t integer or floating point sample type
+ * @tparam delta_t signed type of one delta
+ * @tparam deltas_per_record number of deltas packed in one ring record
+ * @tparam engine_t wear-leveling engine of the block ring, see WL_AT24CX
+ */
+template <class data_t, class delta_t = int8_t, size_t deltas_per_record = 8, class engine_t = wl_engine_ptr_crc16>
+class WL_DELTA_AT24CX {
+   public:
+    typedef wl_delta_block_t<data_t, delta_t, deltas_per_record> block_t;
+    typedef WL_AT24CX<block_t, engine_t> ring_t;
+
+    /**
+     * @brief Construct a new WL_DELTA_AT24CX object
+     *
+     * @param index EEPROM index (A2 A1 A0)
+     * @param pageSize EEPROM page size, from the manual
+     * @param base_addr base eeprom address. get_end_addr() can be used to chain next class base address in ctor
+     * @param num_of_data number of blocks to be stored in eeprom
+     * @param resolution value of one delta step, floating point data is rounded to it. Must be 1 for integers
+     * @param eeprom_size eeprom size, in bytes
+     */
+    WL_DELTA_AT24CX(
+        byte index,
+        byte pageSize,
+        uint32_t base_addr,
+        uint32_t num_of_data,
+        double resolution    = 1,
+        uint32_t eeprom_size = 1 << 15)
+        : ring(index, pageSize, base_addr, num_of_data, eeprom_size)
+    {
+        static_assert(std::is_arithmetic<data_t>::value, "delta encoding needs numeric data");
+        static_assert(std::is_signed<delta_t>::value, "delta_t must be signed");
+        static_assert(deltas_per_record <= 0xFF, "delta count is stored in one byte");
+        assert(std::is_floating_point<data_t>::value || resolution == 1);
+
+        this->resolution = resolution;
+    }
+
+    WL_DELTA_AT24CX(const WL_DELTA_AT24CX &)            = delete;
+    WL_DELTA_AT24CX &operator=(const WL_DELTA_AT24CX &) = delete;
+
+    /**
+     * @brief Write the open block before the object goes away
+     *
+     */
+    ~WL_DELTA_AT24CX()
+    {
+        wl_power_fail_unregister();
+        flush();
+    }
+
+    /**
+     * @brief Initialize ring, then decode last block to get last value
+     *
+     */
+    void wl_init()
+    {
+        ring.wl_init3();
+        block_open = false;
+
+        data_t samples[deltas_per_record + 1];
+        has_value = ring.wl_history_each(1, [&](const typename ring_t::record_t &record) {
+            last_value = samples[decode(record.data, samples) - 1];
+            return false;
+        }) > 0;
+    }
+
+    /**
+     * @brief push sample, a ring record is written once its block is closed
+     *
+     * @param data sample to be stored
+     */
+    void wl_push(const data_t data)
+    {
+        delta_t delta;
+        if (block_open && encode(last_value, data, delta)) {
+            block.delta[block.count++] = delta;
+            last_value                 = apply(last_value, delta);
+        } else {
+            flush();
+            block_open     = true;
+            block.base     = data;
+            block.count    = 0;
+            last_value     = data;
+            block_first_ms = millis();
+        }
+        has_value = true;
+
+        if (block.count == deltas_per_record || block_isold())
+            flush();
+    }
+
+    /**
+     * @brief Close the open block once it is older than max_age_ms, bounds the samples a reset loses
+     * to that time span. A longer span packs more deltas per block, a shorter one loses less
+     *
+     * @param max_age_ms max age of the open block in ms, 0 means no time limit
+     */
+    void wl_delta_max_age(uint32_t max_age_ms)
+    {
+        max_age = max_age_ms;
+    }
+
+    /**
+     * @brief Write the open block if it exceeds its max age. Call periodically, e.g. from loop()
+     *
+     */
+    void wl_service()
+    {
+        if (block_isold())
+            flush();
+    }
+
+    /**
+     * @brief Add this instance to the list committed by wl_power_fail_commit() and wl_power_fail_service(),
+     * the open block is written then
+     *
+     */
+    void wl_power_fail_register()
+    {
+        wl_power_fail_insert(pf_hook, &power_fail_thunk, this);
+    }
+
+    /**
+     * @brief Remove this instance from the power-fail list
+     *
+     */
+    void wl_power_fail_unregister()
+    {
+        wl_power_fail_remove(pf_hook);
+    }
+
+    /**
+     * @brief Write the open block to eeprom, next sample starts a new keyframe
+     *
+     */
+    void flush()
+    {
+        if (!block_open)
+            return;
+
+        // unused deltas stay erased
+        memset(block.delta + block.count, 0xFF, sizeof(delta_t) * (deltas_per_record - block.count));
+        ring.wl_push(block);
+        block_open = false;
+    }
+
+    /**
+     * @brief Get the last sample, as decoded from its block
+     *
+     * @return data_t last sample
+     */
+    data_t wl_get_last_data()
+    {
+        return has_value ? last_value : data_t();
+    }
+
+    /**
+     * @brief Read the most recent samples, decoding blocks while they are read in bursts
+     *
+     * @param out output array, at least max_count elements
+     * @param max_count max number of samples to read
+     * @param newest_first true for newest-to-oldest, false for oldest-to-newest order
+     * @return uint32_t number of samples stored in out
+     */
+    uint32_t wl_history(data_t *out, uint32_t max_count, bool newest_first = true)
+    {
+        data_t samples[deltas_per_record + 1];
+        uint32_t count = 0;
+
+        if (block_open) {
+            for (uint32_t i = decode(block, samples); i > 0 && count < max_count; i--)
+                out[count++] = samples[i - 1];
+        }
+
+        // every block holds at least one sample
+        ring.wl_history_each(max_count - count, [&](const typename ring_t::record_t &record) {
+            for (uint32_t i = decode(record.data, samples); i > 0 && count < max_count; i--)
+                out[count++] = samples[i - 1];
+            return count < max_count;
+        });
+
+        if (!newest_first)
+            std::reverse(out, out + count);
+
+        return count;
+    }
+
+    /**
+     * @brief Get end address (upper bounds) for this object
+     * end address can be used as another wl_at24cx base address
+     *
+     * @return * uint32_t end address
+     */
+    uint32_t get_end_addr()
+    {
+        return ring.get_end_addr();
+    }
+
+   private:
+    ring_t ring;
+
+    double resolution;
+
+    block_t block;           // open block, not written yet
+    bool block_open = false;
+
+    unsigned long block_first_ms = 0; // millis() of first sample in the open block
+    uint32_t max_age             = 0; // max age of the open block, 0 means no time limit
+
+    // power-fail list node, allocated by wl_power_fail_register()
+    wl_power_fail_hook_t *pf_hook = nullptr;
+
+    data_t last_value = data_t();
+    bool has_value    = false;
+
+    /**
+     * @brief check whether the open block exceeds its max age
+     */
+    bool block_isold()
+    {
+        return block_open && max_age > 0 && millis() - block_first_ms >= max_age;
+    }
+
+    static void power_fail_thunk(void *ctx)
+    {
+        static_cast<WL_DELTA_AT24CX *>(ctx)->flush();
+    }
+
+    /**
+     * @brief express step from last to data as a delta
+     *
+     * @return false if the step does not fit in delta_t, data needs a keyframe
+     */
+    bool encode(data_t last, data_t data, delta_t &delta)
+    {
+        double steps;
+        if (std::is_floating_point<data_t>::value)
+            steps = std::round((static_cast<double>(data) - static_cast<double>(last)) / resolution);
+        else
+            steps = static_cast<double>(data) - static_cast<double>(last);
+
+        if (!std::isfinite(steps))
+            return false;
+        if (steps < std::numeric_limits<delta_t>::min() || steps > std::numeric_limits<delta_t>::max())
+            return false;
+
+        delta = static_cast<delta_t>(steps);
+        return true;
+    }
+
+    /**
+     * @brief sample following last, used by both encoder and decoder so they never drift apart
+     */
+    data_t apply(data_t last, delta_t delta)
+    {
+        if (std::is_floating_point<data_t>::value)
+            return last + static_cast<data_t>(delta * resolution);
+        else
+            return static_cast<data_t>(last + delta);
+    }
+
+    /**
+     * @brief decode block into samples, oldest first
+     *
+     * @param input block
+     * @param samples output, deltas_per_record + 1 elements
+     * @return uint32_t number of samples
+     */
+    uint32_t decode(const block_t &input, data_t *samples)
+    {
+        uint32_t count = min<uint32_t>(input.count, deltas_per_record);
+
+        samples[0] = input.base;
+        for (uint32_t i = 0; i < count; i++)
+            samples[i + 1] = apply(samples[i], input.delta[i]);
+
+        return count + 1;
+    }
+};
+
+#endif
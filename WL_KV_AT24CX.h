@@ -0,0 +1,435 @@
+/**
+ * @file WL_KV_AT24CX.h
+ * @brief Log-structured key-value store on a wear-leveled AT24CX ring
+ *
+ * Every put appends a (seq, key, value, crc) record at the ring head, the same way WL_AT24CX pushes.
+ * A RAM index holds the slot of the latest record of each key and is rebuilt by kv_init().
+ * Live records are moved from the ring tail to the head before the head reaches them, so all
+ * keys share one region and every slot wears evenly.
+ *
+ * The crc is a CRC-16/CCITT over the whole record, and the head must carry the seq following the
+ * record before it, so a put torn by a power cut is dropped at boot and the key keeps its old value.
+ */
+#ifndef WL_KV_AT24CX_h
+#define WL_KV_AT24CX_h
+
+#include "AT24CX.h"
+
+template <size_t value_size>
+struct kv_record_t {
+    uint32_t seq;
+    uint8_t key;
+    uint8_t len; // number of bytes used in value
+    uint8_t value[value_size];
+    uint16_t crc;
+} __attribute__((packed)); // packed to ensure sizeof returns correct struct size
+
+/**
+ * @brief Key-value store object based on AT24CX library
+ *
+ * @tparam value_size max size of a value, in bytes
+ * @tparam max_keys keys are 0 to max_keys - 1
+ */
+template <size_t value_size, size_t max_keys>
+class WL_KV_AT24CX : public AT24CX {
+   public:
+    /**
+     * @brief Construct a new WL_KV_AT24CX object
+     *
+     * @param index EEPROM index (A2 A1 A0)
+     * @param pageSize EEPROM page size, from the manual
+     * @param base_addr base eeprom address
+     * @param num_of_slots number of records in the ring, at least max_keys + 2
+     * @param eeprom_size eeprom size, in bytes
+     */
+    WL_KV_AT24CX(
+        byte index,
+        byte pageSize,
+        uint32_t base_addr,
+        uint32_t num_of_slots,
+        uint32_t eeprom_size = 1 << 15)
+        : AT24CX(index, pageSize)
+    {
+        // every key may be live at once, compaction needs one more free slot to make progress
+        assert(num_of_slots >= max_keys + 2);
+        static_assert(max_keys <= 0xFF, "key is stored in one byte");
+        static_assert(value_size <= 0xFF, "value length is stored in one byte");
+
+        this->base_addr    = base_addr;
+        this->num_of_slots = num_of_slots;
+        this->eeprom_size  = eeprom_size;
+        kv_set_low_water(num_of_slots / 4 + 1);
+
+        end_addr = base_addr + record_size * num_of_slots;
+
+        for (uint32_t key = 0; key < max_keys; key++)
+            key_slot[key] = slot_none;
+
+        ESP_LOGD("EEPROM KV", "Starting KV store, size of kv_record_t: %d bytes", record_size);
+    }
+
+    /**
+     * @brief Initialize by scanning the whole ring, rebuilds key_slot index and finds the head
+     *
+     */
+    void kv_init()
+    {
+        scan_t state = scan(seq_erased);
+        if (state.found && state.indexed_max > state.seq_max) {
+            // a record newer than the head does not follow the ring, index again without it
+            ESP_LOGW("EEPROM KV", "Dropped records past seq %u, torn put", state.seq_max);
+            state = scan(state.seq_max);
+        }
+
+        if (state.found) {
+            head     = slot_step(state.slot_max);
+            seq_next = state.seq_max + 1;
+        } else {
+            head     = 0;
+            seq_next = 0;
+        }
+
+        // first live record at or after head is the tail
+        tail = head;
+        if (live_count > 0) {
+            while (!slot_islive(tail))
+                tail = slot_step(tail);
+        }
+
+        ESP_LOGI("EEPROM KV", "Obtained head = %u, %u keys, %u free slots", head, live_count, kv_free_slots());
+    }
+
+    /**
+     * @brief store value of key, compacts first when the ring has no spare slot
+     *
+     * @tparam T trivially copyable type, at most value_size bytes
+     * @param key key, 0 to max_keys - 1
+     * @param value value to be stored
+     */
+    template <class T>
+    void kv_put(uint8_t key, const T &value)
+    {
+        static_assert(sizeof(T) <= value_size, "value does not fit in kv record");
+        assert(key < max_keys);
+
+        while (kv_free_slots() < 2)
+            kv_compact_step();
+
+        append(key, reinterpret_cast<const uint8_t *>(&value), sizeof(T));
+    }
+
+    /**
+     * @brief get last value stored for key
+     *
+     * @tparam T type used in kv_put
+     * @param key key, 0 to max_keys - 1
+     * @param value output, untouched if key is not found
+     * @return true if key is found and record is valid
+     */
+    template <class T>
+    bool kv_get(uint8_t key, T &value)
+    {
+        static_assert(sizeof(T) <= value_size, "value does not fit in kv record");
+        assert(key < max_keys);
+
+        if (key_slot[key] == slot_none)
+            return false;
+
+        kv_record_t<value_size> record = peek(key_slot[key]);
+        if (!isrecordvalid(record) || record.key != key || record.len != sizeof(T)) {
+            ESP_LOGE("EEPROM KV", "Record of key %u at slot %u is corrupted", key, key_slot[key]);
+            return false;
+        }
+
+        memcpy(&value, record.value, sizeof(T));
+        return true;
+    }
+
+    /**
+     * @brief check whether key has a stored value
+     *
+     * @param key key, 0 to max_keys - 1
+     */
+    bool kv_contains(uint8_t key)
+    {
+        return (key < max_keys) && (key_slot[key] != slot_none);
+    }
+
+    /**
+     * @brief Background compaction, moves one live record when free slots are below low water mark.
+     * Call periodically, e.g. from loop(), to keep compaction out of kv_put().
+     * Does nothing once every used slot is live, no compaction could free a slot then
+     *
+     */
+    void kv_service()
+    {
+        if (kv_free_slots() < low_water && kv_dead_slots() > 0)
+            kv_compact_step();
+    }
+
+    /**
+     * @brief Set number of free slots kv_service() tries to keep
+     *
+     * @param slots low water mark, defaults to a quarter of the ring
+     */
+    void kv_set_low_water(uint32_t slots)
+    {
+        low_water = min<uint32_t>(slots, num_of_slots - max_keys);
+    }
+
+    /**
+     * @brief Number of slots that can be written before a live record is reached
+     *
+     * @return uint32_t free slots
+     */
+    uint32_t kv_free_slots()
+    {
+        if (live_count == 0)
+            return num_of_slots;
+        return (tail + num_of_slots - head) % num_of_slots;
+    }
+
+    /**
+     * @brief Number of slots between tail and head holding an outdated record, compaction frees them
+     *
+     * @return uint32_t dead slots
+     */
+    uint32_t kv_dead_slots()
+    {
+        return num_of_slots - kv_free_slots() - live_count;
+    }
+
+    /**
+     * @brief Move the oldest live record to the head, frees at least its slot
+     *
+     */
+    void kv_compact_step()
+    {
+        if (live_count == 0)
+            return;
+
+        kv_record_t<value_size> record = peek(tail);
+        if (!isrecordvalid(record) || key_slot[record.key] != tail) {
+            // record went bad after init, drop its key and carry on
+            for (uint32_t key = 0; key < max_keys; key++) {
+                if (key_slot[key] == tail) {
+                    ESP_LOGE("EEPROM KV", "Record of key %u at slot %u is corrupted, key dropped", key, tail);
+                    key_slot[key] = slot_none;
+                    live_count--;
+                }
+            }
+            while (live_count > 0 && !slot_islive(tail))
+                tail = slot_step(tail);
+            return;
+        }
+
+        append(record.key, record.value, record.len);
+    }
+
+    /**
+     * @brief Get end address (upper bounds) for this object
+     * end address can be used as another wl_at24cx base address
+     *
+     * @return * uint32_t end address
+     */
+    uint32_t get_end_addr()
+    {
+        return end_addr;
+    }
+
+   private:
+    static const uint32_t slot_none    = std::numeric_limits<uint32_t>::max();
+    static const uint32_t seq_erased   = std::numeric_limits<uint32_t>::max();
+    static const uint32_t record_size  = sizeof(kv_record_t<value_size>);
+    static const uint32_t scan_records = (32 + record_size - 1) / record_size; // records per init read
+
+    uint32_t eeprom_size;
+
+    uint32_t base_addr;
+    uint32_t end_addr;
+
+    uint32_t num_of_slots;
+
+    uint32_t head     = 0; // slot to be written
+    uint32_t tail     = 0; // oldest live slot
+    uint32_t seq_next = 0; // seq to be written
+
+    uint32_t low_water;
+
+    uint32_t key_slot[max_keys]; // slot of latest record of each key
+    uint32_t live_count = 0;     // number of keys in key_slot
+
+    // kv_init() result
+    struct scan_t {
+        bool found;           // head found
+        uint32_t seq_max;     // seq of head record
+        uint32_t slot_max;    // slot of head record
+        uint32_t indexed_max; // highest seq in key_slot
+    };
+
+    uint32_t slot_to_addr(uint32_t slot)
+    {
+        return base_addr + slot * record_size;
+    }
+
+    uint32_t slot_step(uint32_t slot)
+    {
+        return (slot + 1) % num_of_slots;
+    }
+
+    /**
+     * @brief check whether slot holds the latest record of any key
+     */
+    bool slot_islive(uint32_t slot)
+    {
+        for (uint32_t key = 0; key < max_keys; key++) {
+            if (key_slot[key] == slot)
+                return true;
+        }
+        return false;
+    }
+
+    /**
+     * @brief write record at head, update key_slot and move tail past dead slots
+     */
+    void append(uint8_t key, const uint8_t *value, uint8_t len)
+    {
+        kv_record_t<value_size> record;
+        memset(&record, 0xFF, sizeof(record));
+        record.seq = seq_next;
+        record.key = key;
+        record.len = len;
+        memcpy(record.value, value, len);
+        record.crc = calc_crc(record);
+
+        write(slot_to_addr(head), reinterpret_cast<byte *>(&record), record_size);
+
+        if (live_count == 0)
+            tail = head;
+        if (key_slot[key] == slot_none)
+            live_count++;
+        key_slot[key] = head;
+
+        seq_next++;
+        head = slot_step(head);
+
+        while (!slot_islive(tail))
+            tail = slot_step(tail);
+    }
+
+    /**
+     * @brief read the whole ring, index the latest record of each key up to seq_limit and find the head.
+     * The head is the valid record with the highest seq whose slot before holds seq - 1, or is erased
+     *
+     * @param seq_limit records with a higher seq are skipped
+     */
+    scan_t scan(uint32_t seq_limit)
+    {
+        uint32_t key_seq[max_keys];
+        kv_record_t<value_size> chunk[scan_records];
+        scan_t out = {};
+
+        for (uint32_t key = 0; key < max_keys; key++)
+            key_slot[key] = slot_none;
+        live_count = 0;
+
+        bool prev_valid   = false; // record in slot before
+        bool prev_erased  = false;
+        uint32_t prev_seq = 0;
+        kv_record_t<value_size> first; // slot 0 follows the last slot, checked once that is read
+
+        // sequential read of several records per request
+        for (uint32_t slot = 0; slot < num_of_slots; slot += scan_records) {
+            uint32_t n = num_of_slots - slot;
+            if (n > scan_records)
+                n = scan_records;
+            read(slot_to_addr(slot), reinterpret_cast<byte *>(chunk), n * record_size);
+
+            for (uint32_t i = 0; i < n; i++) {
+                const kv_record_t<value_size> &record = chunk[i];
+                bool valid = isrecordvalid(record) && record.seq <= seq_limit;
+
+                if (slot + i == 0)
+                    first = record;
+                else if (valid)
+                    scan_head(out, slot + i, record.seq, prev_valid, prev_erased, prev_seq);
+                prev_valid  = valid;
+                prev_erased = record.seq == seq_erased;
+                prev_seq    = record.seq;
+
+                if (!valid)
+                    continue;
+                if (key_slot[record.key] == slot_none) {
+                    live_count++;
+                } else if (record.seq < key_seq[record.key]) {
+                    continue; // older copy of this key
+                }
+                key_slot[record.key] = slot + i;
+                key_seq[record.key]  = record.seq;
+                out.indexed_max      = max(out.indexed_max, record.seq);
+            }
+        }
+
+        if (isrecordvalid(first) && first.seq <= seq_limit)
+            scan_head(out, 0, first.seq, prev_valid, prev_erased, prev_seq);
+
+        return out;
+    }
+
+    /**
+     * @brief take record at slot as head if it follows the slot before and is newer than the head so far
+     */
+    void scan_head(scan_t &state, uint32_t slot, uint32_t seq, bool prev_valid, bool prev_erased, uint32_t prev_seq)
+    {
+        bool linked = prev_valid ? prev_seq + 1 == seq : prev_erased;
+        if (linked && (!state.found || seq > state.seq_max)) {
+            state.found    = true;
+            state.seq_max  = seq;
+            state.slot_max = slot;
+        }
+    }
+
+    kv_record_t<value_size> peek(uint32_t slot)
+    {
+        kv_record_t<value_size> out;
+        read(slot_to_addr(slot), reinterpret_cast<byte *>(&out), record_size);
+        return out;
+    }
+
+    /**
+     * @brief CRC-16/CCITT (polynomial 0x1021, init 0xFFFF) over every record byte except crc
+     *
+     * @param record kv record
+     * @return uint16_t 16-bit crc
+     */
+    uint16_t calc_crc(const kv_record_t<value_size> &record)
+    {
+        uint16_t output        = 0xFFFF;
+        const uint8_t *dataptr = reinterpret_cast<const uint8_t *>(&record);
+
+        for (size_t i = 0; i < record_size - sizeof(record.crc); i++) {
+            output ^= dataptr[i] << 8;
+            for (uint8_t bit = 0; bit < 8; bit++)
+                output = (output & 0x8000) ? (output << 1) ^ 0x1021 : (output << 1);
+        }
+
+        return output;
+    }
+
+    /**
+     * @brief function to check record validity, erased slots are invalid
+     *
+     * @param record kv record
+     * @return true means record is written, in key range and crc is valid
+     */
+    bool isrecordvalid(const kv_record_t<value_size> &record)
+    {
+        if (record.seq == seq_erased)
+            return false;
+        if (record.key >= max_keys || record.len > value_size)
+            return false;
+        return record.crc == calc_crc(record);
+    }
+};
+
+#endif
@@ -0,0 +1,383 @@
+/**
+ * @file WL_LOG_AT24CX.h
+ * @brief Variable-length record log on a wear-leveled AT24CX region
+ *
+ * Records are (header, payload) pairs packed back to back in the region. Every lap starts at offset 0:
+ * a record that does not fit before the end of the region is written at offset 0, overwriting the
+ * oldest records. Boot follows headers from offset 0 to the newest record, headers carry the offset
+ * of the previous record so reads go newest-to-oldest across the lap boundary.
+ */
+#ifndef WL_LOG_AT24CX_h
+#define WL_LOG_AT24CX_h
+
+#include "AT24CX.h"
+
+struct wl_log_header_t {
+    uint32_t seq;  // record number, 0xFFFFFFFF is erased
+    uint16_t len;  // payload length in bytes
+    uint16_t prev; // offset of previous record
+    uint16_t dcrc; // CRC-16 of payload
+    uint16_t hcrc; // CRC-16 of header bytes before it
+} __attribute__((packed)); // packed to ensure sizeof returns correct struct size
+
+/**
+ * @brief Variable-length log object based on AT24CX library
+ *
+ * @tparam max_len max payload length of a record, in bytes
+ */
+template <size_t max_len>
+class WL_LOG_AT24CX : public AT24CX {
+   public:
+    /**
+     * @brief Construct a new WL_LOG_AT24CX object
+     *
+     * @param index EEPROM index (A2 A1 A0)
+     * @param pageSize EEPROM page size, from the manual
+     * @param base_addr base eeprom address
+     * @param size region size in bytes, at most 65536
+     * @param eeprom_size eeprom size, in bytes
+     */
+    WL_LOG_AT24CX(
+        byte index,
+        byte pageSize,
+        uint32_t base_addr,
+        uint32_t size,
+        uint32_t eeprom_size = 1 << 15)
+        : AT24CX(index, pageSize)
+    {
+        static_assert(max_len < 0xFFFF, "payload length is stored in two bytes");
+        // offsets are stored in two bytes, a record must fit twice so one lap survives the next
+        assert(size <= 0x10000 && size >= 2 * (header_size + max_len));
+        assert(base_addr + size <= eeprom_size);
+
+        this->base_addr   = base_addr;
+        this->size        = size;
+        this->eeprom_size = eeprom_size;
+
+        end_addr = base_addr + size;
+
+        ESP_LOGD("EEPROM LOG", "Starting log, %u bytes, header %u bytes", size, header_size);
+    }
+
+    /**
+     * @brief Initialize by following record headers from offset 0 to the newest record.
+     * Headers are read in sequential bursts, payloads are skipped. Only when the header at offset 0
+     * is torn the whole region is scanned for the newest header
+     *
+     */
+    void log_init()
+    {
+        chunk_len = 0;
+        has_last  = false;
+        head      = 0;
+        limit     = 0;
+        seq_next  = 0;
+
+        wl_log_header_t header;
+        peek_header(0, header);
+
+        if (isheadererased(header)) {
+            ESP_LOGI("EEPROM LOG", "Log is empty");
+            return;
+        }
+
+        if (!isheadervalid(header)) {
+            // lap start is torn, newest record is somewhere in the previous lap
+            scan_newest();
+            return;
+        }
+
+        // follow the current lap
+        uint32_t off   = 0;
+        uint32_t count = 1;
+        for (;;) {
+            uint32_t next = off + header_size + header.len;
+            wl_log_header_t candidate;
+            if (next + header_size > size)
+                break;
+            peek_header(next, candidate);
+            if (!isheadervalid(candidate) || candidate.seq != header.seq + 1 || candidate.prev != off)
+                break;
+            off    = next;
+            header = candidate;
+            count++;
+        }
+
+        uint32_t end = off + header_size + header.len;
+        if (!ispayloadvalid(off, header)) {
+            // newest record is torn, write the next one in its place
+            ESP_LOGW("EEPROM LOG", "Record %u at offset %u is torn, dropped", header.seq, off);
+            limit    = end;
+            head     = off;
+            seq_next = header.seq;
+            if (header.prev != offset_none) {
+                has_last = true;
+                last     = header.prev;
+            }
+        } else {
+            has_last = true;
+            last     = off;
+            head     = end;
+            limit    = end;
+            seq_next = header.seq + 1;
+        }
+
+        ESP_LOGI("EEPROM LOG", "Obtained head = %u, seq %u, %u headers read", head, seq_next, count);
+    }
+
+    /**
+     * @brief Append a record, overwriting the oldest records when the region is full
+     *
+     * @param data payload
+     * @param len payload length, at most max_len
+     */
+    void log_append(const void *data, uint16_t len)
+    {
+        assert(len <= max_len);
+
+        uint8_t buffer[header_size + max_len];
+        wl_log_header_t header;
+        header.seq  = seq_next;
+        header.len  = len;
+        header.prev = has_last ? last : offset_none;
+        header.dcrc = crc16(0xFFFF, reinterpret_cast<const uint8_t *>(data), len);
+        header.hcrc = crc16(0xFFFF, reinterpret_cast<const uint8_t *>(&header), hcrc_size);
+        memcpy(buffer, &header, header_size);
+        memcpy(buffer + header_size, data, len);
+
+        uint32_t n   = header_size + len;
+        uint32_t off = head;
+        if (off + n > size) {
+            off   = 0; // new lap, previous lap stays readable behind it
+            limit = 0;
+        }
+
+        // header and payload in one write, a torn payload is caught by dcrc at boot
+        write(base_addr + off, buffer, n);
+
+        has_last = true;
+        last     = off;
+        head     = off + n;
+        limit    = max<uint32_t>(limit, head);
+        seq_next++;
+        chunk_len = 0; // burst buffer may hold old bytes
+    }
+
+    /**
+     * @brief Visit records newest-to-oldest. Stops at the first damaged record, at a record that was
+     * overwritten by the current lap, or after max_count records
+     *
+     * @tparam visitor_t callable as bool(uint32_t seq, const uint8_t *data, uint16_t len), return false to stop
+     * @param max_count max number of records to read
+     * @param visit called for every valid record
+     * @return uint32_t number of records visited
+     */
+    template <class visitor_t>
+    uint32_t log_each(uint32_t max_count, visitor_t visit)
+    {
+        uint8_t buffer[max_len];
+        uint32_t count = 0;
+
+        if (!has_last)
+            return 0;
+
+        uint32_t off     = last;
+        uint32_t seq     = seq_next - 1;
+        bool lap_crossed = last >= head; // newest record is in the previous lap after a dropped lap start
+        while (count < max_count) {
+            if (lap_crossed && off < limit)
+                break; // overwritten by the current lap
+
+            wl_log_header_t header;
+            read(base_addr + off, reinterpret_cast<byte *>(&header), header_size);
+            if (!isheadervalid(header) || header.seq != seq || header.len > max_len)
+                break;
+            read(base_addr + off + header_size, buffer, header.len);
+            if (crc16(0xFFFF, buffer, header.len) != header.dcrc)
+                break;
+
+            count++;
+            if (!visit(header.seq, buffer, header.len))
+                break;
+
+            // previous record is either earlier in this lap or at the end of the lap before
+            uint32_t prev = header.prev;
+            if (prev == offset_none || seq == 0)
+                break;
+            if (prev >= off) {
+                if (lap_crossed)
+                    break;
+                lap_crossed = true;
+            }
+            off = prev;
+            seq--;
+        }
+
+        return count;
+    }
+
+    /**
+     * @brief Read the newest record
+     *
+     * @param out output, at least max_len bytes
+     * @param len output, payload length
+     * @return true if a valid record is found
+     */
+    bool log_get_last(void *out, uint16_t &len)
+    {
+        return log_each(1, [&](uint32_t, const uint8_t *data, uint16_t n) {
+                   memcpy(out, data, n);
+                   len = n;
+                   return false;
+               }) > 0;
+    }
+
+    /**
+     * @brief Get number of records appended since the log was empty
+     *
+     * @return uint32_t seq of next record
+     */
+    uint32_t log_get_seq()
+    {
+        return seq_next;
+    }
+
+    /**
+     * @brief Get end address (upper bounds) for this object
+     * end address can be used as another wl_at24cx base address
+     *
+     * @return * uint32_t end address
+     */
+    uint32_t get_end_addr()
+    {
+        return end_addr;
+    }
+
+   private:
+    static const uint32_t header_size = sizeof(wl_log_header_t);
+    static const uint32_t hcrc_size   = header_size - sizeof(uint16_t); // header bytes covered by hcrc
+    static const uint16_t offset_none = 0xFFFF; // prev of the first record
+    static const uint32_t seq_erased  = 0xFFFFFFFF;
+
+    uint32_t eeprom_size;
+
+    uint32_t base_addr;
+    uint32_t end_addr;
+
+    uint32_t size;
+
+    uint32_t head     = 0; // offset of next record, if it fits
+    uint32_t last     = 0; // offset of newest record
+    bool has_last     = false;
+    uint32_t limit    = 0; // end of bytes written in current lap, previous lap is intact from here
+    uint32_t seq_next = 0;
+
+    // burst buffer for header reads at init
+    uint8_t chunk[32];
+    uint32_t chunk_off = 0;
+    uint32_t chunk_len = 0;
+
+    /**
+     * @brief read header at offset, from the burst buffer when it is already there
+     */
+    void peek_header(uint32_t off, wl_log_header_t &header)
+    {
+        if (off < chunk_off || off + header_size > chunk_off + chunk_len) {
+            chunk_off = off;
+            chunk_len = min<uint32_t>(sizeof(chunk), size - off);
+            read(base_addr + off, chunk, chunk_len);
+        }
+        memcpy(&header, chunk + off - chunk_off, header_size);
+    }
+
+    /**
+     * @brief find newest valid header by checking every offset, used when offset 0 is torn.
+     * Next record starts a new lap at offset 0 again
+     */
+    void scan_newest()
+    {
+        bool found    = false;
+        uint32_t best = 0;
+        uint32_t seq  = 0;
+
+        uint8_t window[sizeof(chunk) + header_size];
+        uint32_t carry = 0; // bytes from previous burst not checked yet
+        for (uint32_t off = 0; off < size; off += sizeof(chunk)) {
+            uint32_t n = min<uint32_t>(sizeof(chunk), size - off);
+            read(base_addr + off, window + carry, n);
+            uint32_t avail = carry + n;
+            uint32_t start = off - carry;
+
+            uint32_t i;
+            for (i = 0; i + header_size <= avail; i++) {
+                wl_log_header_t header;
+                memcpy(&header, window + i, header_size);
+                if (!isheadervalid(header) || (found && header.seq <= seq))
+                    continue;
+                if (start + i + header_size + header.len > size || !ispayloadvalid(start + i, header))
+                    continue;
+                found = true;
+                best  = start + i;
+                seq   = header.seq;
+            }
+            carry = avail - i;
+            memmove(window, window + i, carry);
+        }
+
+        head  = 0;
+        limit = 0;
+        if (found) {
+            has_last = true;
+            last     = best;
+            seq_next = seq + 1;
+        }
+
+        ESP_LOGW("EEPROM LOG", "Lap start is torn, scanned log, newest seq %u at offset %u", seq, best);
+    }
+
+    bool ispayloadvalid(uint32_t off, const wl_log_header_t &header)
+    {
+        uint8_t buffer[max_len];
+        if (header.len > max_len)
+            return false;
+        read(base_addr + off + header_size, buffer, header.len);
+        return crc16(0xFFFF, buffer, header.len) == header.dcrc;
+    }
+
+    bool isheadererased(const wl_log_header_t &header)
+    {
+        const uint8_t *dataptr = reinterpret_cast<const uint8_t *>(&header);
+        for (size_t i = 0; i < header_size; i++) {
+            if (dataptr[i] != 0xFF)
+                return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief function to check header validity, erased headers are invalid
+     *
+     * @return true means header is written, its length fits and crc is valid
+     */
+    bool isheadervalid(const wl_log_header_t &header)
+    {
+        if (header.seq == seq_erased || header.len > max_len)
+            return false;
+        return header.hcrc == crc16(0xFFFF, reinterpret_cast<const uint8_t *>(&header), hcrc_size);
+    }
+
+    /**
+     * @brief CRC-16/CCITT, polynomial 0x1021, start with 0xFFFF
+     */
+    static uint16_t crc16(uint16_t crc, const uint8_t *dataptr, size_t len)
+    {
+        for (size_t i = 0; i < len; i++) {
+            crc ^= dataptr[i] << 8;
+            for (uint8_t bit = 0; bit < 8; bit++)
+                crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1);
+        }
+        return crc;
+    }
+};
+
+#endif
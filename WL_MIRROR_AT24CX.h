@@ -0,0 +1,138 @@
+/**
+ * @file WL_MIRROR_AT24CX.h
+ * @brief Wear-leveled ring mirrored on two chips or two regions
+ *
+ * Every push goes to both rings with deferred write completion, so when the rings are on
+ * different chips the second write runs during the write cycle of the first one.
+ * wl_init() takes the newest record whose crc is valid in either ring, and brings the other
+ * ring up to date under the same pointer, so a torn head slot in one ring loses no data.
+ * A ring that lags by more than one push, e.g. on a replaced chip, is erased before the copy.
+ */
+#ifndef WL_MIRROR_AT24CX_h
+#define WL_MIRROR_AT24CX_h
+
+#include "WL_AT24CX.h"
+
+/**
+ * @brief Mirrored EEPROM object based on WL_AT24CX
+ *
+ * @tparam data_t data type to be stored in eeprom
+ * @tparam engine_t wear-leveling engine of both rings, see WL_AT24CX
+ */
+template <class data_t, class engine_t = wl_engine_ptr_crc16>
+class WL_MIRROR_AT24CX {
+   public:
+    /**
+     * @brief Construct a new WL_MIRROR_AT24CX object
+     *
+     * @param index_a EEPROM index (A2 A1 A0) of first ring
+     * @param base_addr_a base eeprom address of first ring
+     * @param index_b EEPROM index (A2 A1 A0) of second ring, may equal index_a
+     * @param base_addr_b base eeprom address of second ring, must not overlap first ring on the same chip
+     * @param pageSize EEPROM page size, from the manual
+     * @param num_of_data number of data to be stored in each ring
+     * @param eeprom_size eeprom size, in bytes
+     */
+    WL_MIRROR_AT24CX(
+        byte index_a,
+        uint32_t base_addr_a,
+        byte index_b,
+        uint32_t base_addr_b,
+        byte pageSize,
+        uint32_t num_of_data,
+        uint32_t eeprom_size = 1 << 15)
+        : ring{
+              {index_a, pageSize, base_addr_a, num_of_data, eeprom_size},
+              {index_b, pageSize, base_addr_b, num_of_data, eeprom_size},
+          }
+    {
+        assert(index_a != index_b || base_addr_b >= ring[0].get_end_addr() || ring[1].get_end_addr() <= base_addr_a);
+
+        ring[0].setDeferredWrite(true);
+        ring[1].setDeferredWrite(true);
+    }
+
+    /**
+     * @brief Initialize both rings, then resync the ring that lags behind
+     *
+     */
+    void wl_init()
+    {
+        ring[0].wl_init3();
+        ring[1].wl_init3();
+
+        // wl_init3 stops at the newest record with valid crc, serial compare keeps order across wraparound
+        uint32_t ptr_a = ring[0].wl_get_ptr();
+        uint32_t ptr_b = ring[1].wl_get_ptr();
+        newest         = ring[0].wl_ptr_isnewer(ptr_b, ptr_a) ? 1 : 0;
+
+        if (ptr_a != ptr_b) {
+            WL_AT24CX<data_t, engine_t> &lagging = ring[1 - newest];
+            ESP_LOGW("EEPROM MIRROR", "Ring %u lags behind (ptr %u vs %u), resync", 1 - newest, ptr_a, ptr_b);
+
+            // copy goes under the pointer of the newest record, a jump in the sequence of the
+            // lagging ring would not be linked to its older records, so that ring starts over
+            uint32_t ptr_last = lagging.wl_ptr_prev(ring[newest].wl_get_ptr());
+            if (lagging.wl_get_ptr() != ptr_last) {
+                erase(lagging);
+                lagging.wl_set_ptr(ptr_last);
+            }
+            lagging.wl_push(ring[newest].wl_get_last_data());
+            lagging.sync();
+        }
+    }
+
+    /**
+     * @brief push data to both rings, returns once both write cycles are over
+     *
+     * @param data data to be put in eeprom
+     */
+    void wl_push(const data_t data)
+    {
+        ring[0].wl_push(data);
+        ring[1].wl_push(data); // overlaps write cycle of ring 0 when on another chip
+        ring[0].sync();
+        ring[1].sync();
+        newest = 0;
+    }
+
+    /**
+     * @brief Get the last data stored, from the ring holding the newest valid record
+     *
+     * @return data_t data last stored
+     */
+    data_t wl_get_last_data()
+    {
+        return ring[newest].wl_get_last_data();
+    }
+
+    /**
+     * @brief Get end address (upper bounds) of the second ring
+     * end address can be used as another wl_at24cx base address
+     *
+     * @return * uint32_t end address
+     */
+    uint32_t get_end_addr()
+    {
+        return ring[1].get_end_addr();
+    }
+
+   private:
+    WL_AT24CX<data_t, engine_t> ring[2];
+
+    uint32_t newest = 0; // ring holding the newest record
+
+    /**
+     * @brief erase target ring to 0xFF and start it over empty
+     */
+    void erase(WL_AT24CX<data_t, engine_t> &target)
+    {
+        byte erased[64]; // AT24CX::write splits it at pages
+        memset(erased, 0xFF, sizeof(erased));
+        for (uint32_t addr = target.get_base_addr(); addr < target.get_end_addr(); addr += sizeof(erased))
+            target.write(addr, erased, min<uint32_t>(sizeof(erased), target.get_end_addr() - addr));
+        target.wl_init3();
+    }
+};
+
+#endif
@@ -0,0 +1,136 @@
+/**
+ * @file WL_PLAN_AT24CX.h
+ * @brief Partition planner for several WL_AT24CX rings on one chip
+ *
+ * Every ring gets a page-aligned region big enough for its required lifetime. Pages left over are
+ * handed out one by one to the ring with the smallest lifetime margin, so endurance is balanced
+ * across the chip. Run wl_plan() before constructing the rings and do not start if it fails.
+ */
+#ifndef WL_PLAN_AT24CX_h
+#define WL_PLAN_AT24CX_h
+
+#include "WL_AT24CX.h"
+
+#include <cmath>
+
+/**
+ * @brief One ring of the partition plan
+ */
+struct wl_plan_entry_t {
+    // request
+    uint32_t record_size;   // bytes per ring slot, sizeof(WL_AT24CX<data_t, engine_t>::record_t)
+    double writes_per_hour; // expected push rate
+    double lifetime_hours;  // required lifetime
+
+    // result of wl_plan()
+    uint32_t base_addr;     // page-aligned WL_AT24CX base_addr
+    uint32_t num_of_data;   // WL_AT24CX num_of_data
+    double lifetime_est;    // planned lifetime in hours at rated endurance
+};
+
+/**
+ * @brief Build a plan entry for a WL_AT24CX<data_t, engine_t> ring
+ *
+ * @tparam data_t data type to be stored in eeprom
+ * @tparam engine_t wl_engine_ptr or wl_engine_ptr_crc16
+ * @param writes_per_hour expected number of wl_push per hour
+ * @param lifetime_hours required lifetime
+ * @return wl_plan_entry_t entry to be passed to wl_plan()
+ */
+template <class data_t, class engine_t = wl_engine_ptr>
+wl_plan_entry_t wl_plan_entry(double writes_per_hour, double lifetime_hours)
+{
+    wl_plan_entry_t out = {};
+    out.record_size     = sizeof(typename WL_AT24CX<data_t, engine_t>::record_t);
+    out.writes_per_hour = writes_per_hour;
+    out.lifetime_hours  = lifetime_hours;
+    return out;
+}
+
+/**
+ * @brief Lay out rings on one chip, consecutive and page-aligned
+ *
+ * @param entries rings to be placed, base_addr, num_of_data and lifetime_est are filled in
+ * @param n number of entries
+ * @param eeprom_size eeprom size, in bytes
+ * @param page_size eeprom page size, from the manual
+ * @param endurance rated write cycles per cell
+ * @param base_addr first address available to the plan, page-aligned
+ * @return true if every ring fits with its required lifetime, entries are unusable otherwise
+ */
+inline bool wl_plan(
+    wl_plan_entry_t *entries,
+    uint32_t n,
+    uint32_t eeprom_size,
+    uint32_t page_size,
+    uint32_t endurance = 1000000,
+    uint32_t base_addr = 0)
+{
+    assert(base_addr % page_size == 0);
+
+    uint32_t pages_free = (eeprom_size - base_addr) / page_size;
+
+    // minimum size: every slot takes writes_per_hour * lifetime_hours / num_of_data writes
+    for (uint32_t i = 0; i < n; i++) {
+        wl_plan_entry_t &entry = entries[i];
+        assert(entry.record_size > 0);
+
+        double writes  = entry.writes_per_hour * entry.lifetime_hours;
+        uint32_t slots = max<uint32_t>(2, static_cast<uint32_t>(std::ceil(writes / endurance)));
+        uint32_t pages = (slots * entry.record_size + page_size - 1) / page_size;
+
+        if (pages > pages_free) {
+            ESP_LOGE("EEPROM PLAN", "Entry %u needs %u pages, only %u left", i, pages, pages_free);
+            return false;
+        }
+        pages_free -= pages;
+        entry.num_of_data = pages; // page count until addresses are assigned
+    }
+
+    // balance: next page goes to the ring with the lowest lifetime margin
+    for (; pages_free > 0; pages_free--) {
+        uint32_t worst      = n;
+        double worst_margin = 0;
+        for (uint32_t i = 0; i < n; i++) {
+            const wl_plan_entry_t &entry = entries[i];
+            if (entry.writes_per_hour <= 0)
+                continue;
+
+            double slots  = entry.num_of_data * page_size / entry.record_size;
+            double margin = slots * endurance / (entry.writes_per_hour * entry.lifetime_hours);
+            if (worst == n || margin < worst_margin) {
+                worst        = i;
+                worst_margin = margin;
+            }
+        }
+        if (worst == n)
+            break; // nothing is written, keep spare pages free
+        entries[worst].num_of_data++;
+    }
+
+    uint32_t addr = base_addr;
+    for (uint32_t i = 0; i < n; i++) {
+        wl_plan_entry_t &entry = entries[i];
+        uint32_t pages         = entry.num_of_data;
+
+        entry.base_addr   = addr;
+        entry.num_of_data = pages * page_size / entry.record_size;
+        if (entry.writes_per_hour > 0)
+            entry.lifetime_est = 1.0 * entry.num_of_data * endurance / entry.writes_per_hour;
+        else
+            entry.lifetime_est = std::numeric_limits<double>::infinity();
+        addr += pages * page_size;
+
+        ESP_LOGI(
+            "EEPROM PLAN",
+            "Entry %u: base %u, %u slots, %.0f hours",
+            i,
+            entry.base_addr,
+            entry.num_of_data,
+            entry.lifetime_est);
+    }
+
+    return true;
+}
+
+#endif
@@ -0,0 +1,79 @@
+/**
+ * @file Arduino.h
+ * @brief Minimal Arduino core for building the library on a host (Linux) machine
+ *
+ * Time is simulated: delay() and bus traffic advance sim_bus.time_ns instead of sleeping.
+ * See Wire.h for the simulated AT24Cx devices.
+ */
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+typedef uint8_t byte;
+
+using std::max;
+using std::min;
+
+#define B1010000 0x50
+
+// ESP32 log macros, printed when HOST_LOG_LEVEL is raised (1 = error ... 5 = verbose)
+#ifndef HOST_LOG_LEVEL
+#define HOST_LOG_LEVEL 0
+#endif
+#define HOST_LOG(level, letter, tag, format, ...)                                  \
+    do {                                                                           \
+        if (HOST_LOG_LEVEL >= level)                                               \
+            fprintf(stderr, letter " (%s) " format "\n", tag, ##__VA_ARGS__);      \
+    } while (0)
+#define ESP_LOGE(tag, format, ...) HOST_LOG(1, "E", tag, format, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) HOST_LOG(2, "W", tag, format, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...) HOST_LOG(3, "I", tag, format, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...) HOST_LOG(4, "D", tag, format, ##__VA_ARGS__)
+#define ESP_LOGV(tag, format, ...) HOST_LOG(5, "V", tag, format, ##__VA_ARGS__)
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+
+/**
+ * @brief Arduino Stream subset, readBytes() returns at once when no data is available
+ */
+class Stream {
+   public:
+    virtual ~Stream() {}
+    virtual int available()            = 0;
+    virtual int read()                 = 0;
+    virtual size_t write(uint8_t data) = 0;
+    virtual size_t write(const uint8_t *data, size_t n)
+    {
+        size_t i = 0;
+        while (i < n && write(data[i]))
+            i++;
+        return i;
+    }
+    virtual void flush() {}
+
+    size_t readBytes(uint8_t *data, size_t n)
+    {
+        size_t i = 0;
+        while (i < n && available() > 0)
+            data[i++] = read();
+        return i;
+    }
+    void setTimeout(unsigned long ms)
+    {
+        timeout_ms = ms;
+    }
+
+   protected:
+    unsigned long timeout_ms = 1000;
+};
+
+#endif
@@ -0,0 +1,185 @@
+/**
+ * @file Wire.cpp
+ * @brief Simulated I2C bus and AT24Cx devices for host builds
+ */
+#include "Wire.h"
+
+sim_eeprom_t sim_eeprom[8];
+sim_bus_t sim_bus;
+TwoWire Wire;
+
+// 9 clocks per byte (8 data + ack) at 400 kHz
+static const uint64_t byte_time_ns = 22500;
+
+unsigned long millis()
+{
+    return sim_bus.time_ns / 1000000;
+}
+
+unsigned long micros()
+{
+    return sim_bus.time_ns / 1000;
+}
+
+void delay(unsigned long ms)
+{
+    sim_bus.time_ns += ms * 1000000ULL;
+}
+
+void sim_eeprom_t::erase(uint32_t size, uint32_t page_size)
+{
+    assert(size <= max_size);
+    this->size      = size;
+    this->page_size = page_size;
+    memset(mem, 0xFF, sizeof(mem));
+    memset(wear, 0, sizeof(wear));
+    busy_until_ns = 0;
+}
+
+uint32_t sim_eeprom_t::max_wear(uint32_t begin, uint32_t end) const
+{
+    uint32_t out = 0;
+    for (uint32_t i = begin; i < end && i < size; i++)
+        out = std::max(out, wear[i]);
+    return out;
+}
+
+void sim_bus_t::reset()
+{
+    *this = sim_bus_t();
+    for (sim_eeprom_t &dev : sim_eeprom)
+        dev.busy_until_ns = 0; // clock restarts, a write cycle in progress is over
+}
+
+void sim_bus_t::arm_power_cut(uint64_t cells, bool torn)
+{
+    cut_countdown = cells;
+    cut_torn      = torn;
+}
+
+void sim_bus_t::restore_power()
+{
+    power_lost    = false;
+    cut_countdown = -1;
+    for (sim_eeprom_t &dev : sim_eeprom)
+        dev.busy_until_ns = 0;
+}
+
+void TwoWire::begin()
+{
+    begins++;
+}
+
+void TwoWire::beginTransmission(int address)
+{
+    tx_id  = address;
+    tx_len = 0;
+}
+
+size_t TwoWire::write(uint8_t data)
+{
+    if (tx_len >= sizeof(tx_buf))
+        return 0;
+    tx_buf[tx_len++] = data;
+    return 1;
+}
+
+size_t TwoWire::write(const uint8_t *data, size_t n)
+{
+    size_t out = 0;
+    for (size_t i = 0; i < n; i++)
+        out += write(data[i]);
+    return out;
+}
+
+bool sim_i2c_write(int id, const uint8_t *data, size_t n)
+{
+    sim_bus.transactions++;
+    sim_bus.tx_bytes += n + 1; // device address byte
+    sim_bus.time_ns += (n + 1) * byte_time_ns;
+
+    if ((id & ~0x7) != 0x50 || sim_bus.power_lost)
+        return false; // address NACK
+    sim_eeprom_t &dev = sim_eeprom[id & 0x7];
+    uint32_t &addr    = sim_bus.word_addr[id & 0x7];
+    if (sim_bus.time_ns < dev.busy_until_ns)
+        return false; // write cycle in progress
+
+    if (n >= 2)
+        addr = ((data[0] << 8) | data[1]) % dev.size;
+
+    if (n > 2) {
+        // page write, address counter rolls over inside the page
+        uint32_t page = addr - addr % dev.page_size;
+        for (size_t i = 2; i < n; i++) {
+            uint32_t cell = page + (addr + i - 2) % dev.page_size;
+            if (sim_bus.cut_countdown == 0) {
+                if (sim_bus.cut_torn)
+                    dev.mem[cell] = rand();
+                sim_bus.power_lost    = true;
+                sim_bus.cut_countdown = -1;
+                if (sim_bus.on_power_cut != nullptr)
+                    sim_bus.on_power_cut();
+                break;
+            }
+            if (sim_bus.cut_countdown > 0)
+                sim_bus.cut_countdown--;
+            dev.mem[cell]  = data[i];
+            dev.wear[cell] = dev.wear[cell] + 1;
+        }
+        addr              = page + (addr + n - 2) % dev.page_size;
+        dev.busy_until_ns = sim_bus.time_ns + dev.write_cycle_ns;
+        sim_bus.write_cycles++;
+        sim_bus.cell_writes += n - 2;
+    }
+    return true;
+}
+
+bool sim_i2c_read(int id, uint8_t *data, size_t n)
+{
+    sim_bus.transactions++;
+    sim_bus.tx_bytes++;
+    sim_bus.time_ns += (n + 1) * byte_time_ns;
+
+    if ((id & ~0x7) != 0x50 || sim_bus.power_lost)
+        return false;
+    sim_eeprom_t &dev = sim_eeprom[id & 0x7];
+    uint32_t &addr    = sim_bus.word_addr[id & 0x7];
+    if (sim_bus.time_ns < dev.busy_until_ns)
+        return false;
+
+    // sequential read, address counter rolls over at the end of the chip
+    for (size_t i = 0; i < n; i++) {
+        data[i] = dev.mem[addr];
+        addr    = (addr + 1) % dev.size;
+    }
+    sim_bus.rx_bytes += n;
+    return true;
+}
+
+uint8_t TwoWire::endTransmission(bool sendStop)
+{
+    (void)sendStop;
+    return sim_i2c_write(tx_id, tx_buf, tx_len) ? 0 : 2;
+}
+
+uint8_t TwoWire::requestFrom(int address, int quantity)
+{
+    rx_pos = 0;
+    rx_len = min<size_t>(quantity, sizeof(rx_buf));
+    if (!sim_i2c_read(address, rx_buf, rx_len))
+        rx_len = 0;
+    return rx_len;
+}
+
+int TwoWire::available()
+{
+    return rx_len - rx_pos;
+}
+
+int TwoWire::read()
+{
+    if (rx_pos >= rx_len)
+        return -1;
+    return rx_buf[rx_pos++];
+}
@@ -0,0 +1,123 @@
+/**
+ * @file Wire.h
+ * @brief Host replacement of Arduino Wire with up to eight simulated AT24Cx EEPROMs on the bus
+ *
+ * Devices answer at 0x50 | index. Each write transaction programs its bytes inside one page,
+ * wrapping at the page boundary like the real chip, then NACKs its address for the write cycle.
+ * Bus time is modelled at 400 kHz.
+ * Power can be cut at any programmed byte with sim_bus_t::arm_power_cut(), devices stay
+ * unpowered (address NACK, writes lost) until sim_bus_t::reset() or restore_power().
+ */
+#ifndef HOST_WIRE_H
+#define HOST_WIRE_H
+
+#include <Arduino.h>
+
+/**
+ * @brief Simulated AT24Cx device
+ */
+struct sim_eeprom_t {
+    static const uint32_t max_size = 1 << 16;
+
+    uint32_t size      = 1 << 15; // bytes, AT24C256 by default
+    uint32_t page_size = 64;      // bytes
+
+    uint8_t mem[max_size];
+    uint32_t wear[max_size]; // number of times each cell was programmed
+
+    uint64_t write_cycle_ns = 5000000; // tWR, typical of AT24C256, 0 for FRAM
+    uint64_t busy_until_ns  = 0;       // address is NACKed until then
+
+    /**
+     * @brief reset device to erased (0xFF) state and clear wear counters
+     */
+    void erase(uint32_t size = 1 << 15, uint32_t page_size = 64);
+
+    /**
+     * @brief highest wear counter in [begin, end)
+     */
+    uint32_t max_wear(uint32_t begin, uint32_t end) const;
+};
+
+/**
+ * @brief Bus traffic counters and simulated clock
+ */
+struct sim_bus_t {
+    uint64_t time_ns;      // simulated time, advanced by bus traffic and delay()
+    uint64_t transactions; // number of START conditions
+    uint64_t tx_bytes;     // bytes sent by master, address bytes included
+    uint64_t rx_bytes;     // bytes read from devices
+    uint64_t write_cycles; // write transactions that programmed cells
+    uint64_t cell_writes;  // total bytes programmed
+
+    // power-cut injection
+    int64_t cut_countdown  = -1;      // bytes left to program before power fails, -1 means never
+    bool cut_torn          = false;   // byte at the cut gets a random value, otherwise it keeps the old one
+    bool power_lost        = false;   // devices NACK every transaction
+    void (*on_power_cut)() = nullptr; // called when power fails
+
+    uint32_t word_addr[8] = {0}; // internal address counter of each device
+
+    /**
+     * @brief clear counters and clock, power on, devices idle, no cut armed
+     */
+    void reset();
+
+    /**
+     * @brief fail power when the (cells + 1)-th byte from now is programmed.
+     * Bytes before it in the same page write are programmed, bytes after it are not
+     *
+     * @param cells bytes programmed normally before the cut
+     * @param torn true to leave a random value in the byte at the cut
+     */
+    void arm_power_cut(uint64_t cells, bool torn);
+
+    /**
+     * @brief power devices again, counters are kept
+     */
+    void restore_power();
+};
+
+extern sim_eeprom_t sim_eeprom[8];
+extern sim_bus_t sim_bus;
+
+/**
+ * @brief one write transaction: START, device address, data, STOP. Used by Wire and the ESP-IDF fake
+ *
+ * @return false if the device NACKs its address
+ */
+bool sim_i2c_write(int id, const uint8_t *data, size_t n);
+
+/**
+ * @brief one read transaction from the device address counter
+ *
+ * @return false if the device NACKs its address
+ */
+bool sim_i2c_read(int id, uint8_t *data, size_t n);
+
+class TwoWire {
+   public:
+    void begin();
+    void beginTransmission(int address);
+    size_t write(uint8_t data);
+    size_t write(const uint8_t *data, size_t n);
+    uint8_t endTransmission(bool sendStop = true);
+    uint8_t requestFrom(int address, int quantity);
+    int available();
+    int read();
+
+    uint32_t begins = 0; // calls of begin()
+
+   private:
+    int tx_id = -1;
+    uint8_t tx_buf[512];
+    size_t tx_len = 0;
+
+    uint8_t rx_buf[512];
+    size_t rx_len = 0;
+    size_t rx_pos = 0;
+};
+
+extern TwoWire Wire;
+
+#endif
@@ -0,0 +1,54 @@
+/**
+ * @file i2c.h
+ * @brief Host fake of the ESP-IDF legacy I2C master command-link API, on the simulated bus of Wire.h
+ *
+ * Only the calls used by AT24CX_IDF.h are provided. A command link is executed as a list of
+ * START/STOP separated transactions: an address byte, then writes or reads. A NACKed address makes
+ * i2c_master_cmd_begin() return ESP_FAIL like the driver. Ticks are milliseconds.
+ */
+#ifndef HOST_DRIVER_I2C_H
+#define HOST_DRIVER_I2C_H
+
+#include <Arduino.h>
+
+typedef int esp_err_t;
+#define ESP_OK 0
+#define ESP_FAIL -1
+#define ESP_ERR_INVALID_ARG 0x102
+#define ESP_ERR_TIMEOUT 0x107
+
+typedef int i2c_port_t;
+#define I2C_NUM_0 0
+#define I2C_NUM_1 1
+
+typedef uint32_t TickType_t;
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+
+typedef enum {
+    I2C_MASTER_WRITE = 0,
+    I2C_MASTER_READ,
+} i2c_rw_t;
+
+typedef enum {
+    I2C_MASTER_ACK = 0,
+    I2C_MASTER_NACK,
+    I2C_MASTER_LAST_NACK,
+} i2c_ack_type_t;
+
+typedef void *i2c_cmd_handle_t;
+
+// bytes of a static command link, enough for the given number of device transactions
+#define I2C_LINK_RECOMMENDED_SIZE(TRANSACTIONS) (4 * sizeof(void *) * (2 + 5 * (TRANSACTIONS)))
+
+i2c_cmd_handle_t i2c_cmd_link_create_static(uint8_t *buffer, uint32_t size);
+void i2c_cmd_link_delete_static(i2c_cmd_handle_t cmd_handle);
+esp_err_t i2c_master_start(i2c_cmd_handle_t cmd_handle);
+esp_err_t i2c_master_write_byte(i2c_cmd_handle_t cmd_handle, uint8_t data, bool ack_en);
+esp_err_t i2c_master_write(i2c_cmd_handle_t cmd_handle, const uint8_t *data, size_t data_len, bool ack_en);
+esp_err_t i2c_master_read(i2c_cmd_handle_t cmd_handle, uint8_t *data, size_t data_len, i2c_ack_type_t ack);
+esp_err_t i2c_master_stop(i2c_cmd_handle_t cmd_handle);
+esp_err_t i2c_master_cmd_begin(i2c_port_t i2c_num, i2c_cmd_handle_t cmd_handle, TickType_t ticks_to_wait);
+
+const char *esp_err_to_name(esp_err_t code);
+
+#endif
@@ -0,0 +1,138 @@
+/**
+ * @file i2c.cpp
+ * @brief Host fake of the ESP-IDF I2C master command link, see driver/i2c.h
+ */
+#include <cstddef>
+#include <new>
+#include <vector>
+
+#include "Wire.h"
+#include "driver/i2c.h"
+
+namespace {
+
+struct cmd_op_t {
+    enum { start, stop, write, read } type;
+    const uint8_t *data; // write source or read destination, nullptr for a single byte write
+    uint8_t byte;
+    size_t len;
+};
+
+// lives in the caller's buffer, ops fill the rest of it
+struct cmd_link_t {
+    size_t capacity;
+    size_t count;
+    cmd_op_t ops[1];
+
+    esp_err_t add(const cmd_op_t &op)
+    {
+        if (count >= capacity)
+            return ESP_FAIL;
+        ops[count++] = op;
+        return ESP_OK;
+    }
+};
+
+} // namespace
+
+i2c_cmd_handle_t i2c_cmd_link_create_static(uint8_t *buffer, uint32_t size)
+{
+    if (size < sizeof(cmd_link_t))
+        return nullptr;
+    cmd_link_t *link = new (buffer) cmd_link_t();
+    link->capacity   = (size - offsetof(cmd_link_t, ops)) / sizeof(cmd_op_t);
+    link->count      = 0;
+    return link;
+}
+
+void i2c_cmd_link_delete_static(i2c_cmd_handle_t cmd_handle)
+{
+    static_cast<cmd_link_t *>(cmd_handle)->~cmd_link_t();
+}
+
+esp_err_t i2c_master_start(i2c_cmd_handle_t cmd_handle)
+{
+    return static_cast<cmd_link_t *>(cmd_handle)->add({cmd_op_t::start, nullptr, 0, 0});
+}
+
+esp_err_t i2c_master_stop(i2c_cmd_handle_t cmd_handle)
+{
+    return static_cast<cmd_link_t *>(cmd_handle)->add({cmd_op_t::stop, nullptr, 0, 0});
+}
+
+esp_err_t i2c_master_write_byte(i2c_cmd_handle_t cmd_handle, uint8_t data, bool)
+{
+    return static_cast<cmd_link_t *>(cmd_handle)->add({cmd_op_t::write, nullptr, data, 1});
+}
+
+esp_err_t i2c_master_write(i2c_cmd_handle_t cmd_handle, const uint8_t *data, size_t data_len, bool)
+{
+    return static_cast<cmd_link_t *>(cmd_handle)->add({cmd_op_t::write, data, 0, data_len});
+}
+
+esp_err_t i2c_master_read(i2c_cmd_handle_t cmd_handle, uint8_t *data, size_t data_len, i2c_ack_type_t)
+{
+    if (data_len == 0)
+        return ESP_ERR_INVALID_ARG;
+    return static_cast<cmd_link_t *>(cmd_handle)->add({cmd_op_t::read, data, 0, data_len});
+}
+
+esp_err_t i2c_master_cmd_begin(i2c_port_t, i2c_cmd_handle_t cmd_handle, TickType_t)
+{
+    cmd_link_t &link = *static_cast<cmd_link_t *>(cmd_handle);
+
+    int id       = -1; // device of current transaction, -1 before its address byte
+    bool reading = false;
+    std::vector<uint8_t> tx;
+
+    // a write transaction goes to the device when it ends, at STOP or repeated START
+    auto end_transaction = [&]() {
+        bool ack = true;
+        if (id >= 0 && !reading)
+            ack = sim_i2c_write(id, tx.data(), tx.size());
+        id = -1;
+        tx.clear();
+        return ack;
+    };
+
+    for (size_t i = 0; i < link.count; i++) {
+        const cmd_op_t &op = link.ops[i];
+        if (op.type == cmd_op_t::start || op.type == cmd_op_t::stop) {
+            if (!end_transaction())
+                return ESP_FAIL;
+        } else if (op.type == cmd_op_t::write) {
+            const uint8_t *data = op.data ? op.data : &op.byte;
+            size_t first        = 0;
+            if (id < 0) {
+                id      = data[0] >> 1;
+                reading = data[0] & 1;
+                first   = 1;
+            }
+            if (reading && op.len > first)
+                return ESP_ERR_INVALID_ARG; // data write in a read transaction
+            tx.insert(tx.end(), data + first, data + op.len);
+        } else {
+            if (id < 0 || !reading)
+                return ESP_ERR_INVALID_ARG;
+            if (!sim_i2c_read(id, const_cast<uint8_t *>(op.data), op.len))
+                return ESP_FAIL;
+        }
+    }
+    return end_transaction() ? ESP_OK : ESP_FAIL;
+}
+
+const char *esp_err_to_name(esp_err_t code)
+{
+    switch (code) {
+        case ESP_OK:
+            return "ESP_OK";
+        case ESP_FAIL:
+            return "ESP_FAIL";
+        case ESP_ERR_INVALID_ARG:
+            return "ESP_ERR_INVALID_ARG";
+        case ESP_ERR_TIMEOUT:
+            return "ESP_ERR_TIMEOUT";
+        default:
+            return "UNKNOWN ERROR";
+    }
+}
@@ -0,0 +1,189 @@
+/**
+ * @file image_check.cpp
+ * @brief Host check of AT24CX_Image dump and restore over a loopback Stream between simulated AT24C256
+ *
+ * The loopback stream runs at 115200 baud on the simulated clock, so bus and serial time add up as on
+ * the device.
+ * round trip: a random region of chip 0 is dumped and restored to chip 1. The region must match, bytes
+ * around it must stay erased, and a restore over the same bytes must write nothing. A restore must not
+ * wait for more write cycles than its bus writes after the first one of each block, the write cycle of
+ * the last one runs while the next frame is received.
+ * corrupt: a bit of a random byte of the stream is flipped. Restore must fail, not with
+ * AT24CX_IMAGE_CHECKSUM since the frame crc catches it, and must write the frames before the damaged
+ * one and nothing else.
+ * truncated: the stream ends at a random byte. Restore must stop with AT24CX_IMAGE_TIMEOUT and must
+ * write the complete frames and nothing else.
+ *
+ * Build and run from repository root:
+ *   g++ -std=gnu++11 -O2 -Iextras/host -I. AT24CX.cpp extras/host/Wire.cpp \
+ *       extras/image_check/image_check.cpp -o image_check && ./image_check [trials] [seed]
+ */
+#include <Wire.h>
+#include <deque>
+
+#include "AT24CX_Image.h"
+
+static const uint64_t byte_ns = 10 * 1000000000ULL / 115200; // start, 8 data and stop bits
+
+/**
+ * @brief bytes written are read back in order, reads take serial time
+ */
+struct loopback_t : Stream {
+    std::deque<uint8_t> bytes;
+
+    int available()
+    {
+        return bytes.size();
+    }
+
+    int read()
+    {
+        if (bytes.empty())
+            return -1;
+        uint8_t out = bytes.front();
+        bytes.pop_front();
+        sim_bus.time_ns += byte_ns;
+        return out;
+    }
+
+    size_t write(uint8_t data)
+    {
+        bytes.push_back(data);
+        return 1;
+    }
+};
+
+/**
+ * @brief fill chip 0 with random bytes and dump a random region of it
+ */
+static void dump(loopback_t &stream, uint32_t &address, uint32_t &size)
+{
+    sim_eeprom[0].erase();
+    for (uint32_t i = 0; i < sim_eeprom[0].size; i++)
+        sim_eeprom[0].mem[i] = rand();
+    address = rand() % 20000;
+    size    = 1 + rand() % 8000;
+
+    AT24CX source(0, 64);
+    AT24CX_Image image(source, stream);
+    image.dump(address, size);
+}
+
+/**
+ * @brief first byte of chip 1 that differs from chip 0 inside the region, or is not erased outside it
+ */
+static uint32_t first_difference(uint32_t address, uint32_t size)
+{
+    for (uint32_t i = 0; i < sim_eeprom[1].size; i++) {
+        uint8_t expected = (i >= address && i < address + size) ? sim_eeprom[0].mem[i] : 0xFF;
+        if (sim_eeprom[1].mem[i] != expected)
+            return i;
+    }
+    return sim_eeprom[1].size;
+}
+
+static uint32_t check_round_trip(uint32_t trials)
+{
+    uint32_t errors = 0, late = 0;
+    uint64_t rewritten = 0, bytes = 0;
+    for (uint32_t t = 0; t < trials; t++) {
+        loopback_t stream;
+        uint32_t address, size;
+        dump(stream, address, size);
+        std::deque<uint8_t> copy = stream.bytes;
+
+        sim_eeprom[1].erase();
+        sim_bus.reset();
+        AT24CX target(1, 64);
+        AT24CX_Image image(target, stream);
+        errors += image.restore() != AT24CX_IMAGE_OK;
+        errors += first_difference(address, size) != sim_eeprom[1].size;
+        bytes += image.written();
+
+        // serial, bus and the write cycles that cannot overlap reception of the next frame, each wait
+        // may be up to 1 ms longer as write cycles are timed with millis()
+        const uint64_t cycle_ns = (AT24CX_WRITE_CYCLE + 1) * 1000000ULL;
+        uint64_t writes         = sim_bus.write_cycles;
+        uint64_t frames         = (size + AT24CX_IMAGE_FRAME - 1) / AT24CX_IMAGE_FRAME;
+        uint64_t bound          = copy.size() * byte_ns + (sim_bus.tx_bytes + sim_bus.rx_bytes) * 22500;
+        bound += (writes - frames + 1) * cycle_ns;
+        for (uint64_t k = 1; k < frames; k++) {
+            uint64_t receive = (min<uint64_t>(AT24CX_IMAGE_FRAME, size - k * AT24CX_IMAGE_FRAME) + 10) * byte_ns;
+            bound += receive < cycle_ns ? cycle_ns - receive : 0; // short last frame
+        }
+        late += sim_bus.time_ns > bound;
+
+        stream.bytes = copy;
+        errors += image.restore() != AT24CX_IMAGE_OK || image.written() != 0;
+        rewritten += image.written();
+    }
+
+    printf(
+        "round trip  %u images, %llu bytes written, %llu written again, %u restores waited for write cycles: %u errors\n",
+        trials,
+        (unsigned long long)bytes,
+        (unsigned long long)rewritten,
+        late,
+        errors);
+    return errors + late;
+}
+
+static uint32_t check_damaged(const char *name, bool truncate, uint32_t trials)
+{
+    uint32_t errors = 0, lost = 0;
+    for (uint32_t t = 0; t < trials; t++) {
+        loopback_t stream;
+        uint32_t address, size;
+        dump(stream, address, size);
+
+        // data of the frames before the damaged byte must be restored, nothing after it
+        uint32_t at  = rand() % stream.bytes.size();
+        uint32_t end = address;
+        for (uint32_t off = 0;;) {
+            uint32_t n    = stream.bytes[off + 6] | (stream.bytes[off + 7] << 8);
+            uint32_t next = off + 8 + n + 2;
+            if (at < next)
+                break;
+            if (stream.bytes[off + 1] == 'D')
+                end += n;
+            off = next;
+        }
+        lost += address + size - end;
+
+        if (truncate)
+            stream.bytes.resize(at);
+        else
+            stream.bytes[at] ^= 1 << (rand() % 8);
+
+        sim_eeprom[1].erase();
+        sim_bus.reset();
+        AT24CX target(1, 64);
+        AT24CX_Image image(target, stream);
+        AT24CX_ImageStatus status = image.restore();
+
+        // a damaged length or sync byte may end the stream inside a frame or misplace the next one
+        if (truncate)
+            errors += status != AT24CX_IMAGE_TIMEOUT;
+        else
+            errors += status == AT24CX_IMAGE_OK || status == AT24CX_IMAGE_CHECKSUM;
+        errors += first_difference(address, end - address) != sim_eeprom[1].size;
+    }
+
+    printf("%-11s %u images, %u bytes behind the damage not restored: %u errors\n", name, trials, lost, errors);
+    return errors;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t trials = argc > 1 ? strtoul(argv[1], nullptr, 0) : 300;
+    uint32_t seed   = argc > 2 ? strtoul(argv[2], nullptr, 0) : 1;
+    srand(seed);
+
+    uint32_t failures = 0;
+    failures += check_round_trip(trials);
+    failures += check_damaged("corrupt", false, trials);
+    failures += check_damaged("truncated", true, trials);
+
+    printf("%s, %u failures\n", failures ? "FAIL" : "PASS", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,137 @@
+/**
+ * @file wl_async_check.cpp
+ * @brief Host check of wl_push_async() and AT24CX_Async on a simulated AT24C256
+ *
+ * push: two chained rings push through wl_push_async() on one queue, a block of plain data is written
+ * and read back through the same queue, and poll() runs between pushes with random delays. No poll()
+ * may wait for a write cycle, wl_get_last_data() must see every push taken at once, and after the
+ * queue drains wl_verify_last() must hold and a fresh wl_init3() must recover the last value and
+ * pointer of both rings.
+ * wipe: an async wipe of one ring, queued behind its pushes, must leave it empty for a fresh
+ * wl_init3() while the other ring keeps its records.
+ *
+ * Build and run from repository root:
+ *   g++ -std=gnu++11 -O2 -Iextras/host -I. AT24CX.cpp extras/host/Wire.cpp \
+ *       extras/wl_async_check/wl_async_check.cpp -o wl_async_check && ./wl_async_check [trials] [seed]
+ */
+#include <Wire.h>
+
+#include "WL_AT24CX.h"
+
+static const uint32_t slots_a = 37, slots_b = 20;
+static const uint32_t block   = 300; // plain data bytes after the rings
+
+typedef WL_AT24CX<uint32_t> ring_a_t;
+typedef WL_AT24CX<double> ring_b_t;
+
+static uint32_t errors = 0, blocked = 0;
+
+/**
+ * @brief poll() once, it must not wait for a write cycle
+ */
+static void poll(AT24CX_Async &queue)
+{
+    uint64_t start = sim_bus.time_ns;
+    queue.poll();
+    blocked += sim_bus.time_ns - start > 2000000; // one transfer takes well below 2 ms
+}
+
+/**
+ * @brief push value async, polling until the previous push of the ring is done
+ */
+template <class ring_t, class data_t>
+static void push(AT24CX_Async &queue, ring_t &ring, data_t value)
+{
+    while (ring.wl_push_async(queue, value) == nullptr) {
+        poll(queue);
+        delay(rand() % 3);
+    }
+    errors += ring.wl_get_last_data() != value;
+}
+
+static uint32_t check(uint32_t trials)
+{
+    uint32_t pushes = 0, wipes = 0;
+    uint8_t data[block], out[block];
+
+    for (uint32_t t = 0; t < trials; t++) {
+        sim_eeprom[0].erase();
+        sim_bus.reset();
+        AT24CX chip(0, 64);
+        AT24CX_Async queue(chip);
+
+        ring_a_t a(0, 64, 0, slots_a);
+        ring_b_t b(0, 64, a.get_end_addr(), slots_b);
+        uint32_t data_addr = b.get_end_addr();
+        a.wl_init3();
+        b.wl_init3();
+        if (rand() % 2) {
+            a.wl_cache_enable(true);
+            b.wl_cache_enable(true);
+        }
+
+        uint32_t last_a = 0;
+        double last_b   = 0;
+        uint32_t n      = rand() % (3 * slots_a);
+        for (uint32_t i = 0; i < n; i++, pushes++) {
+            if (rand() % 3) {
+                last_a = rand();
+                push(queue, a, last_a);
+            } else {
+                last_b = rand() / 7.0;
+                push(queue, b, last_b);
+            }
+            for (uint32_t p = rand() % 4; p > 0; p--)
+                poll(queue);
+        }
+
+        // plain data through the same queue, behind the pushes
+        AT24CX_Op write_op, read_op;
+        for (uint32_t i = 0; i < block; i++)
+            data[i] = rand();
+        queue.write(write_op, data_addr, data, block);
+        queue.read(read_op, data_addr, out, block);
+
+        // wipe ring a behind everything else
+        bool wipe = rand() % 4 == 0;
+        AT24CX_Op wipe_op;
+        if (wipe) {
+            queue.wipe(wipe_op, a.get_base_addr(), a.get_end_addr() - a.get_base_addr());
+            wipes++;
+        }
+
+        while (queue.busy()) {
+            poll(queue);
+            delay(rand() % 3);
+        }
+        chip.sync();
+        errors += !write_op.done || !read_op.done || memcmp(data, out, block) != 0;
+        errors += b.wl_get_ptr() > 0 && !b.wl_verify_last();
+        errors += !wipe && a.wl_get_ptr() > 0 && !a.wl_verify_last();
+
+        ring_a_t boot_a(0, 64, 0, slots_a);
+        ring_b_t boot_b(0, 64, boot_a.get_end_addr(), slots_b);
+        boot_a.wl_init3();
+        boot_b.wl_init3();
+        if (wipe)
+            errors += boot_a.wl_get_ptr() != 0;
+        else
+            errors += boot_a.wl_get_ptr() != a.wl_get_ptr() || (a.wl_get_ptr() > 0 && boot_a.wl_get_last_data() != last_a);
+        errors += boot_b.wl_get_ptr() != b.wl_get_ptr() || (b.wl_get_ptr() > 0 && boot_b.wl_get_last_data() != last_b);
+    }
+
+    printf("%u trials, %u async pushes, %u async wipes, %u polls waited: %u errors\n", trials, pushes, wipes, blocked, errors);
+    return errors + blocked;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t trials = argc > 1 ? strtoul(argv[1], nullptr, 0) : 1000;
+    uint32_t seed   = argc > 2 ? strtoul(argv[2], nullptr, 0) : 1;
+    srand(seed);
+
+    uint32_t failures = check(trials);
+
+    printf("%s, %u failures\n", failures ? "FAIL" : "PASS", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,142 @@
+/**
+ * @file wl_backend_check.cpp
+ * @brief Host check of WL_AT24CX on every storage backend: I2C EEPROM, I2C FRAM, RAM, file and mmap
+ *
+ * Every backend is wrapped to count its write transfers. With group commit enabled, a random number of
+ * records is pushed, then wl_pending_writes() must equal the transfers flush() actually makes, so the
+ * estimate follows the page size and transfer limit of the backend in use. After the run a new ring on
+ * the same backend must recover the last value pushed.
+ * copy: a copied or assigned AT24CX on its own I2C EEPROM must use its own backend, not the source's.
+ *
+ * Build and run from repository root:
+ *   g++ -std=gnu++11 -O2 -Iextras/host -I. AT24CX.cpp extras/host/Wire.cpp \
+ *       extras/wl_backend_check/wl_backend_check.cpp -o wl_backend_check && ./wl_backend_check [trials] [seed]
+ */
+#include <Wire.h>
+
+#include "AT24CX_File.h"
+#include "WL_AT24CX.h"
+
+static const uint32_t num_of_data = 40;
+static const uint32_t image_size  = 1 << 15;
+
+/**
+ * @brief backend counting its write transfers
+ */
+template <class backend_t>
+struct counted_t : backend_t {
+    uint32_t writes = 0;
+
+    template <class... args_t>
+    explicit counted_t(args_t... args)
+        : backend_t(args...)
+    {
+    }
+
+    void write(unsigned int address, byte *data, int n)
+    {
+        writes++;
+        backend_t::write(address, data, n);
+    }
+};
+
+template <class backend_t>
+static uint32_t check(const char *name, counted_t<backend_t> &backend, uint32_t trials)
+{
+    uint32_t misses = 0, pushes = 0, last = 0;
+    {
+        WL_AT24CX<uint32_t> ring(0, 64, 0, num_of_data);
+        ring.setBackend(&backend);
+        ring.wipe();
+        ring.wl_init3();
+        ring.wl_group_commit(8);
+
+        for (uint32_t t = 0; t < trials; t++) {
+            uint32_t n = rand() % 8;
+            for (uint32_t i = 0; i < n; i++, pushes++) {
+                last = rand();
+                ring.wl_push(last);
+            }
+
+            uint32_t pending = ring.wl_pending_writes();
+            backend.writes   = 0;
+            ring.flush();
+            misses += backend.writes != pending;
+        }
+    }
+
+    WL_AT24CX<uint32_t> reboot(0, 64, 0, num_of_data);
+    reboot.setBackend(&backend);
+    reboot.wl_init3();
+    uint32_t lost = pushes > 0 && reboot.wl_get_last_data() != last;
+
+    printf(
+        "%-12s page %5d, max write %5d: %u flushes, %u pending estimates wrong, last value %s\n",
+        name,
+        backend.pageSize,
+        backend.maxWrite,
+        trials,
+        misses,
+        lost ? "lost" : "kept");
+    return misses + lost;
+}
+
+static uint32_t check_copy()
+{
+    uint32_t errors = 0;
+    sim_eeprom[3].erase();
+    {
+        AT24CX assigned;
+        assigned = AT24CX(3, 64); // source is gone after this line
+        assigned.write(10, (byte)0x42);
+        AT24CX copied(assigned);
+        copied.write(11, (byte)0x43);
+        errors += copied.read(10) != 0x42 || assigned.read(11) != 0x43;
+    }
+    errors += sim_eeprom[3].mem[10] != 0x42 || sim_eeprom[3].mem[11] != 0x43;
+
+    printf("copy         assigned and copied AT24CX on chip 3: %u errors\n", errors);
+    return errors;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t trials = argc > 1 ? strtoul(argv[1], nullptr, 0) : 1000;
+    uint32_t seed   = argc > 2 ? strtoul(argv[2], nullptr, 0) : 1;
+    srand(seed);
+
+    uint32_t failures = 0;
+
+    sim_eeprom[0].erase();
+    counted_t<AT24CX_I2C> eeprom((byte)0, (byte)64);
+    failures += check("I2C EEPROM", eeprom, trials);
+
+    // FRAM has no pages, model it as one page over the whole chip and no write cycle
+    sim_eeprom[1].erase(image_size, image_size);
+    sim_eeprom[1].write_cycle_ns = 0;
+    counted_t<AT24CX_FRAM> fram((byte)1);
+    failures += check("I2C FRAM", fram, trials);
+
+    static byte buffer[image_size];
+    counted_t<AT24CX_RAM> ram(buffer, image_size);
+    failures += check("RAM", ram, trials);
+
+    counted_t<AT24CX_RAM> ram_paged(buffer, image_size, 16);
+    failures += check("RAM paged", ram_paged, trials);
+
+    const char *file_path = "wl_backend_check.img";
+    {
+        counted_t<AT24CX_File> file(file_path, image_size, 64);
+        failures += check("File", file, trials);
+    }
+    {
+        counted_t<AT24CX_MMap> map(file_path, image_size);
+        failures += check("MMap", map, trials);
+    }
+    remove(file_path);
+
+    failures += check_copy();
+
+    printf("%s, %u failures\n", failures ? "FAIL" : "PASS", failures);
+    return failures ? 1 : 0;
+}
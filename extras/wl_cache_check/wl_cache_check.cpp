@@ -0,0 +1,168 @@
+/**
+ * @file wl_cache_check.cpp
+ * @brief Host check of the last-record cache and wl_verify_last() of WL_AT24CX on a simulated AT24C256
+ *
+ * cache: random pushes, reads, flushes and cache toggles on a ring with or without group commit.
+ * wl_get_last_data() must always return the last push, and must not touch the bus once the cache was
+ * filled by a push or a read. wl_verify_last() must hold throughout, and a reboot must find the last
+ * push. Staged records are checked against the record before them, so wl_verify_last() is only
+ * required once eeprom holds a record.
+ * corrupt: a byte of the last record written is flipped in eeprom behind the ring's back.
+ * wl_verify_last() must report it with the cache on, and with the cache off unless the byte is part
+ * of the pointer the default engine does not cover. A flipped byte outside the last record must not
+ * be reported.
+ *
+ * Build and run from repository root:
+ *   g++ -std=gnu++11 -O2 -Iextras/host -I. AT24CX.cpp extras/host/Wire.cpp \
+ *       extras/wl_cache_check/wl_cache_check.cpp -o wl_cache_check && ./wl_cache_check [trials] [seed]
+ */
+#include <Wire.h>
+#include <vector>
+
+#include "WL_AT24CX.h"
+
+static const uint32_t num_of_data = 25;
+static const uint32_t record_size = 2 * sizeof(uint32_t) + 1; // data, pointer and crc of the default engine
+
+typedef WL_AT24CX<uint32_t> ring_t;
+
+/**
+ * @brief check whether eeprom holds a record of the ring at base 0
+ */
+static bool committed(ring_t &ring)
+{
+    for (uint32_t i = 0; i < ring.get_end_addr(); i++)
+        if (sim_eeprom[0].mem[i] != 0xFF)
+            return true;
+    return false;
+}
+
+static uint32_t check_cache(uint32_t trials)
+{
+    uint32_t errors = 0, bus_reads = 0, cached_reads = 0, reads = 0;
+    for (uint32_t t = 0; t < trials; t++) {
+        sim_eeprom[0].erase();
+        sim_bus.reset();
+        ring_t ring(0, 64, 0, num_of_data);
+        ring.wl_init3();
+        bool cached = rand() % 4 != 0;
+        bool warm   = false; // cache filled since it was enabled
+        ring.wl_cache_enable(cached);
+        if (rand() % 2)
+            ring.wl_group_commit(1 + rand() % 8);
+
+        uint32_t last = 0, pushes = 0;
+        uint32_t n    = rand() % (4 * num_of_data);
+        for (uint32_t i = 0; i < n; i++) {
+            switch (rand() % 8) {
+            case 0:
+                ring.flush();
+                break;
+            case 1:
+                cached = !cached;
+                warm   = false;
+                ring.wl_cache_enable(cached);
+                break;
+            case 2:
+            case 3: {
+                if (pushes == 0)
+                    break;
+                uint64_t start = sim_bus.transactions;
+                errors += ring.wl_get_last_data() != last;
+                bool bus = sim_bus.transactions != start;
+                errors += cached && warm && bus;
+                bus_reads += bus;
+                cached_reads += !bus;
+                reads++;
+                warm = cached;
+                break;
+            }
+            default:
+                last = rand();
+                ring.wl_push(last);
+                pushes++;
+                warm = cached;
+                break;
+            }
+            errors += committed(ring) && !ring.wl_verify_last();
+        }
+
+        ring.flush();
+        ring_t reboot(0, 64, 0, num_of_data);
+        reboot.wl_init3();
+        reboot.wl_cache_enable(rand() % 2);
+        errors += reboot.wl_get_ptr() != ring.wl_get_ptr() || (pushes > 0 && reboot.wl_get_last_data() != last);
+    }
+
+    printf("cache       %u reads, %u from the bus, %u from ram: %u errors\n", reads, bus_reads, cached_reads, errors);
+    return errors;
+}
+
+static uint32_t check_corrupt(uint32_t trials)
+{
+    uint32_t missed = 0, false_alarms = 0, older = 0;
+    static uint8_t before[1 << 15];
+    for (uint32_t t = 0; t < trials; t++) {
+        sim_eeprom[0].erase();
+        sim_bus.reset();
+        ring_t ring(0, 64, 0, num_of_data);
+        ring.wl_init3();
+        bool cached = rand() % 2;
+        ring.wl_cache_enable(cached);
+
+        for (uint32_t i = rand() % (3 * num_of_data); i > 0; i--)
+            ring.wl_push(rand());
+        memcpy(before, sim_eeprom[0].mem, sizeof(before));
+        ring.wl_push(rand());
+        if (cached && rand() % 2)
+            ring.wl_get_last_data(); // cache filled by the read instead of the push
+
+        // the last push changed bytes of its record only
+        uint32_t start = 0;
+        for (uint32_t i = 0; i < ring.get_end_addr(); i++)
+            if (sim_eeprom[0].mem[i] != before[i])
+                start = i / record_size * record_size;
+        std::vector<uint32_t> record, other;
+        for (uint32_t i = 0; i < ring.get_end_addr(); i++) {
+            bool pointer = i >= start + sizeof(uint32_t) && i < start + 2 * sizeof(uint32_t);
+            if (i < start || i >= start + record_size)
+                other.push_back(i);
+            else if (cached || !pointer)
+                record.push_back(i);
+        }
+        false_alarms += !ring.wl_verify_last();
+
+        uint32_t at = record[rand() % record.size()];
+        uint8_t old = sim_eeprom[0].mem[at];
+        sim_eeprom[0].mem[at] ^= 1 + rand() % 255;
+        missed += ring.wl_verify_last();
+        sim_eeprom[0].mem[at] = old;
+
+        // a byte outside the last record, an older record or an erased slot
+        at = other[rand() % other.size()];
+        sim_eeprom[0].mem[at] ^= 1 + rand() % 255;
+        older += !ring.wl_verify_last();
+    }
+
+    printf(
+        "corrupt     %u flipped records, %u missed, %u false alarms, %u alarms on an older record\n",
+        trials,
+        missed,
+        false_alarms,
+        older);
+    return missed + false_alarms + older;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t trials = argc > 1 ? strtoul(argv[1], nullptr, 0) : 1000;
+    uint32_t seed   = argc > 2 ? strtoul(argv[2], nullptr, 0) : 1;
+    srand(seed);
+
+    uint32_t failures = 0;
+    failures += check_cache(trials);
+    failures += check_corrupt(trials);
+
+    printf("%s, %u failures\n", failures ? "FAIL" : "PASS", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,288 @@
+/**
+ * @file wl_decode.cpp
+ * @brief Decode WL_AT24CX rings from raw chip images with the firmware headers
+ *
+ * Each image is mapped read-only with AT24CX_MMap and every ring of the layout is initialized with
+ * wl_init3(), then reported: head, last value, records readable back from the head, slots failing
+ * their crc and wear estimates. Images are never modified.
+ *
+ * A ring is given as -r SIZE:BASE:COUNT[:ENGINE]
+ *   SIZE   sizeof(data_t), 1 to 32 bytes
+ *   BASE   base address, or + to chain it after the previous ring like get_end_addr()
+ *   COUNT  num_of_data
+ *   ENGINE ptr (default), crc16 or plain (wl_engine_plain)
+ * Values up to 8 bytes are printed as little endian hex numbers, longer ones as bytes.
+ *
+ * Build and run from repository root:
+ *   g++ -std=gnu++11 -O2 -Iextras/host -I. AT24CX.cpp extras/host/Wire.cpp \
+ *       extras/wl_decode/wl_decode.cpp -o wl_decode
+ *   ./wl_decode [-H] [-e endurance] -r SIZE:BASE:COUNT[:ENGINE] [-r ...] image...
+ *   -H prints the full history of every ring, newest first
+ */
+#include <Wire.h>
+#include <chrono>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+#include "AT24CX_File.h"
+#include "WL_AT24CX.h"
+
+static const uint32_t max_data_size = 32;
+
+enum engine_id_t { engine_ptr, engine_crc16, engine_plain };
+
+struct ring_layout_t {
+    uint32_t data_size;
+    uint32_t base_addr;
+    uint32_t num_of_data;
+    engine_id_t engine;
+};
+
+struct options_t {
+    bool history       = false;
+    uint32_t endurance = 1000000;
+};
+
+/**
+ * @brief data_t of a given size, the bytes are kept as they are in eeprom
+ */
+template <size_t size>
+struct raw_t {
+    uint8_t bytes[size];
+} __attribute__((packed));
+
+template <size_t size>
+static void print_value(const raw_t<size> &value)
+{
+    if (size <= 8) {
+        uint64_t number = 0;
+        for (size_t i = size; i > 0; i--)
+            number = (number << 8) | value.bytes[i - 1];
+        printf("0x%0*llx", (int)(2 * size), (unsigned long long)number);
+    } else {
+        for (size_t i = 0; i < size; i++)
+            printf("%02x", value.bytes[i]);
+    }
+}
+
+template <size_t size, class engine_t>
+static void decode_ring(AT24CX_MMap &image, uint32_t image_size, const ring_layout_t &layout, const options_t &options)
+{
+    typedef raw_t<size> data_t;
+    typedef typename WL_AT24CX<data_t, engine_t>::record_t record_t;
+
+    WL_AT24CX<data_t, engine_t> ring(0, 64, layout.base_addr, layout.num_of_data, image_size);
+    ring.setBackend(&image);
+    ring.wl_set_endurance(options.endurance);
+    ring.wl_init3();
+
+    const uint32_t pointer_max = std::numeric_limits<uint32_t>::max();
+    uint32_t next_ptr          = ring.wl_get_ptr();
+    uint32_t last_ptr          = next_ptr == 0 ? pointer_max - 1 : next_ptr - 1;
+
+    uint32_t errors = 0;
+    uint32_t erased = 0;
+    uint32_t head   = 0; // taddr of last record
+    for (uint32_t taddr = 0; taddr < layout.num_of_data; taddr++) {
+        record_t record = ring.wl_peek(taddr);
+        if (record.ptr == pointer_max)
+            erased++;
+        else if (!ring.wl_isvalid(record))
+            errors++;
+        else if (record.ptr == last_ptr)
+            head = taddr;
+    }
+
+    wl_ring_stats_t stats = ring.wl_ring_stats();
+    if (stats.records_written == 0) {
+        printf("  empty, %u slots erased, %u crc errors\n", erased, errors);
+        return;
+    }
+
+    uint32_t readable = ring.wl_history_each(layout.num_of_data, [](const record_t &) { return true; });
+    wl_wear_report_t wear = ring.wl_wear_report();
+
+    printf("  head taddr %u ptr %u, last ", head, last_ptr);
+    print_value(ring.wl_get_last_data());
+    printf("\n  %u of %u records readable, %u slots erased, %u crc errors\n", readable, stats.records_stored, erased, errors);
+    printf(
+        "  %u laps, slot writes %u..%u, most worn cell %u writes (%.4f%% of %u)\n",
+        stats.laps,
+        stats.slot_writes_min,
+        stats.slot_writes_max,
+        wear.writes_per_cell,
+        wear.endurance_used,
+        options.endurance);
+
+    if (options.history) {
+        ring.wl_history_each(layout.num_of_data, [](const record_t &record) {
+            printf("    ptr %10u  ", record.ptr);
+            print_value(record.data);
+            printf("\n");
+            return true;
+        });
+    }
+}
+
+template <size_t size>
+static void decode_plain(AT24CX_MMap &image, uint32_t image_size, const ring_layout_t &layout, const options_t &options)
+{
+    typedef raw_t<size> data_t;
+
+    WL_AT24CX<data_t, wl_engine_plain> array(0, 64, layout.base_addr, layout.num_of_data, image_size);
+    array.setBackend(&image);
+
+    std::vector<data_t> values(layout.num_of_data);
+    array.read_mem(0, values.data(), layout.num_of_data);
+
+    uint32_t erased = 0;
+    for (const data_t &value : values) {
+        bool blank = true;
+        for (size_t i = 0; i < size; i++)
+            blank = blank && value.bytes[i] == 0xFF;
+        erased += blank;
+    }
+    printf("  plain array, %u of %u slots erased\n", erased, layout.num_of_data);
+
+    if (options.history) {
+        for (uint32_t taddr = 0; taddr < layout.num_of_data; taddr++) {
+            printf("    [%u]  ", taddr);
+            print_value(values[taddr]);
+            printf("\n");
+        }
+    }
+}
+
+/**
+ * @brief instantiate the decoder for data sizes 1 to max_data_size
+ */
+template <size_t size>
+static void decode_sized(AT24CX_MMap &image, uint32_t image_size, const ring_layout_t &layout, const options_t &options)
+{
+    if (layout.data_size != size) {
+        decode_sized<size - 1>(image, image_size, layout, options);
+        return;
+    }
+
+    if (layout.engine == engine_ptr)
+        decode_ring<size, wl_engine_ptr>(image, image_size, layout, options);
+    else if (layout.engine == engine_crc16)
+        decode_ring<size, wl_engine_ptr_crc16>(image, image_size, layout, options);
+    else
+        decode_plain<size>(image, image_size, layout, options);
+}
+
+template <>
+void decode_sized<0>(AT24CX_MMap &, uint32_t, const ring_layout_t &, const options_t &)
+{
+}
+
+static uint32_t record_size(const ring_layout_t &layout)
+{
+    if (layout.engine == engine_plain)
+        return layout.data_size;
+    return layout.data_size + sizeof(uint32_t) + (layout.engine == engine_crc16 ? sizeof(uint16_t) : sizeof(uint8_t));
+}
+
+static bool parse_ring(const char *arg, std::vector<ring_layout_t> &layout)
+{
+    ring_layout_t ring = {};
+    char base[16]      = {};
+    char engine[16]    = "ptr";
+    if (sscanf(arg, "%u:%15[^:]:%u:%15s", &ring.data_size, base, &ring.num_of_data, engine) < 3)
+        return false;
+    if (ring.data_size < 1 || ring.data_size > max_data_size || ring.num_of_data < 1)
+        return false;
+
+    if (strcmp(engine, "ptr") == 0)
+        ring.engine = engine_ptr;
+    else if (strcmp(engine, "crc16") == 0)
+        ring.engine = engine_crc16;
+    else if (strcmp(engine, "plain") == 0)
+        ring.engine = engine_plain;
+    else
+        return false;
+
+    if (strcmp(base, "+") == 0) {
+        const ring_layout_t *prev = layout.empty() ? nullptr : &layout.back();
+        ring.base_addr            = prev ? prev->base_addr + prev->num_of_data * record_size(*prev) : 0;
+    } else {
+        ring.base_addr = strtoul(base, nullptr, 0);
+    }
+
+    layout.push_back(ring);
+    return true;
+}
+
+static const char *engine_name(engine_id_t engine)
+{
+    return engine == engine_ptr ? "ptr" : engine == engine_crc16 ? "crc16" : "plain";
+}
+
+static int usage(const char *name)
+{
+    fprintf(stderr, "usage: %s [-H] [-e endurance] -r SIZE:BASE:COUNT[:ptr|crc16|plain] [-r ...] image...\n", name);
+    return 2;
+}
+
+int main(int argc, char **argv)
+{
+    options_t options;
+    std::vector<ring_layout_t> layout;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "He:r:")) != -1) {
+        if (opt == 'H') {
+            options.history = true;
+        } else if (opt == 'e') {
+            options.endurance = strtoul(optarg, nullptr, 0);
+        } else if (opt == 'r') {
+            if (!parse_ring(optarg, layout)) {
+                fprintf(stderr, "bad ring '%s'\n", optarg);
+                return usage(argv[0]);
+            }
+        } else {
+            return usage(argv[0]);
+        }
+    }
+    if (layout.empty() || optind >= argc)
+        return usage(argv[0]);
+
+    int failed = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = optind; i < argc; i++) {
+        struct stat st;
+        if (stat(argv[i], &st) != 0 || st.st_size == 0) {
+            fprintf(stderr, "%s: cannot read image\n", argv[i]);
+            failed++;
+            continue;
+        }
+        uint32_t image_size = st.st_size;
+        AT24CX_MMap image(argv[i], image_size, 0, false);
+
+        printf("%s (%u bytes)\n", argv[i], image_size);
+        for (size_t r = 0; r < layout.size(); r++) {
+            const ring_layout_t &ring = layout[r];
+            uint32_t end              = ring.base_addr + ring.num_of_data * record_size(ring);
+            printf(
+                "ring %zu: %s, %u byte data at %u..%u, %u slots\n",
+                r,
+                engine_name(ring.engine),
+                ring.data_size,
+                ring.base_addr,
+                end,
+                ring.num_of_data);
+            if (end > image_size) {
+                printf("  does not fit in image\n");
+                failed++;
+                continue;
+            }
+            decode_sized<max_data_size>(image, image_size, ring, options);
+        }
+    }
+
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    fprintf(stderr, "%d images decoded in %.2f ms\n", argc - optind, ms);
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,145 @@
+/**
+ * @file wl_delta_check.cpp
+ * @brief Host check of WL_DELTA_AT24CX encoding, history and loss window on a simulated AT24C256
+ *
+ * history: samples with small and large steps are pushed, wl_history must return them exactly
+ * (integers) or within half a resolution step (float), also after the object is destroyed and rebooted.
+ * reset: objects are dropped without their destructor to model a reset. With no bound the open block
+ * is lost, with wl_delta_max_age() at most that time span is lost, and with the power-fail hook
+ * committed before the reset nothing is lost.
+ *
+ * Build and run from repository root:
+ *   g++ -std=gnu++11 -O2 -Iextras/host -I. AT24CX.cpp extras/host/Wire.cpp \
+ *       extras/wl_delta_check/wl_delta_check.cpp -o wl_delta_check && ./wl_delta_check
+ */
+#include <Wire.h>
+#include <cmath>
+#include <new>
+
+#include "WL_DELTA_AT24CX.h"
+
+static const uint32_t num_of_data = 64;
+
+typedef WL_DELTA_AT24CX<int32_t> int_ring_t;
+typedef WL_DELTA_AT24CX<float, int8_t, 8> float_ring_t;
+
+static int32_t sample_of(uint32_t i)
+{
+    return (i % 37 == 0) ? (int32_t)(i * 1000) : (int32_t)(i % 11) - 5; // keyframe every now and then
+}
+
+/**
+ * @brief storage for a ring whose destructor never runs, like RAM state lost on reset
+ */
+template <class ring_t>
+struct reset_slot_t {
+    alignas(ring_t) unsigned char storage[sizeof(ring_t)];
+
+    ring_t *create()
+    {
+        return new (storage) ring_t(0, 64, 0, num_of_data);
+    }
+};
+
+static uint32_t check_history()
+{
+    uint32_t failures = 0;
+    const uint32_t count = 150;
+
+    sim_eeprom[0].erase();
+    {
+        int_ring_t ring(0, 64, 0, num_of_data);
+        ring.wl_init();
+        for (uint32_t i = 0; i < count; i++)
+            ring.wl_push(sample_of(i));
+    }
+
+    int_ring_t reboot(0, 64, 0, num_of_data);
+    reboot.wl_init();
+    int32_t out[count];
+    uint32_t n = reboot.wl_history(out, count, false);
+    for (uint32_t i = 0; i < n; i++)
+        failures += out[i] != sample_of(i);
+    failures += n != count || reboot.wl_get_last_data() != sample_of(count - 1);
+    printf("history int:   %u of %u samples after teardown and reboot, %u errors\n", n, count, failures);
+
+    uint32_t float_errors = 0;
+    sim_eeprom[0].erase();
+    {
+        float_ring_t ring(0, 64, 0, num_of_data, 0.1);
+        ring.wl_init();
+        for (uint32_t i = 0; i < count; i++)
+            ring.wl_push(20.0f + 5 * std::sin(i * 0.3f) + (i == 70 ? 100 : 0));
+    }
+    float_ring_t freboot(0, 64, 0, num_of_data, 0.1);
+    freboot.wl_init();
+    float fout[count];
+    n = freboot.wl_history(fout, count, false);
+    for (uint32_t i = 0; i < n; i++)
+        float_errors += std::fabs(fout[i] - (20.0f + 5 * std::sin(i * 0.3f) + (i == 70 ? 100 : 0))) > 0.051;
+    float_errors += n != count;
+    printf("history float: %u of %u samples after teardown and reboot, %u errors\n", n, count, float_errors);
+
+    return failures + float_errors;
+}
+
+/**
+ * @brief push samples 1 s apart, reset without destructor, count samples readable after reboot
+ *
+ * @param mode 0 no bound, 1 max age, 2 power-fail commit before the reset
+ */
+static uint32_t samples_after_reset(int mode, uint32_t pushes, uint32_t max_age_ms)
+{
+    static reset_slot_t<int_ring_t> slot;
+
+    sim_eeprom[0].erase();
+    sim_bus.reset();
+    int_ring_t *ring = slot.create();
+    ring->wl_init();
+    if (mode == 1)
+        ring->wl_delta_max_age(max_age_ms);
+    if (mode == 2)
+        ring->wl_power_fail_register();
+    for (uint32_t i = 0; i < pushes; i++) {
+        ring->wl_push(1);
+        delay(1000);
+        ring->wl_service();
+    }
+    if (mode == 2) {
+        wl_power_fail_notify();
+        wl_power_fail_service();
+        ring->wl_power_fail_unregister(); // list must not keep the node of a dropped object
+    }
+
+    int_ring_t reboot(0, 64, 0, num_of_data);
+    reboot.wl_init();
+    int32_t out[256];
+    return reboot.wl_history(out, 256);
+}
+
+static uint32_t check_reset()
+{
+    uint32_t failures = 0;
+    const uint32_t pushes = 100;
+
+    uint32_t unbounded = samples_after_reset(0, pushes, 0);
+    uint32_t aged      = samples_after_reset(1, pushes, 3000);
+    uint32_t committed = samples_after_reset(2, pushes, 0);
+
+    printf("reset: %u pushes, %u kept with no bound, %u with max age 3 s, %u with power-fail commit\n", pushes, unbounded, aged, committed);
+
+    failures += pushes - unbounded > 9; // at most one open block of deltas_per_record + 1
+    failures += pushes - aged > 4;      // 3 s of samples, one per second
+    failures += committed != pushes;
+    return failures;
+}
+
+int main()
+{
+    uint32_t failures = 0;
+    failures += check_history();
+    failures += check_reset();
+
+    printf("%s, %u failures\n", failures ? "FAIL" : "PASS", failures);
+    return failures ? 1 : 0;
+}
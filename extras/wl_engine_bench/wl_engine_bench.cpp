@@ -0,0 +1,73 @@
+/**
+ * @file wl_engine_bench.cpp
+ * @brief Host benchmark comparing wl_engine_ptr and wl_engine_avr101 on a simulated AT24C256
+ *
+ * Both engines get the same eeprom region. Reports bytes written per push, init time after a long
+ * run and the number of pushes until the most worn cell reaches the rated endurance.
+ *
+ * Build and run from repository root:
+ *   g++ -std=gnu++11 -O2 -Iextras/host -I. AT24CX.cpp extras/host/Wire.cpp \
+ *       extras/wl_engine_bench/wl_engine_bench.cpp -o wl_engine_bench && ./wl_engine_bench
+ */
+#include <Wire.h>
+
+#include "WL_AT24CX.h"
+
+static const uint32_t region_size = 1024;    // bytes given to each engine
+static const uint32_t pushes      = 20000;   // pushes per run
+static const uint32_t endurance   = 1000000; // rated write cycles per cell
+
+template <class data_t, class engine_t>
+static void bench(const char *name, uint32_t record_size)
+{
+    uint32_t num_of_data = region_size / record_size;
+    if (num_of_data % 255 == 0)
+        num_of_data--; // avr101 restriction, keep both engines comparable
+
+    sim_eeprom[0].erase();
+    sim_bus.reset();
+
+    WL_AT24CX<data_t, engine_t> eeprom(0, 64, 0, num_of_data);
+    eeprom.wl_init();
+
+    sim_bus.reset();
+    for (uint32_t i = 0; i < pushes; i++)
+        eeprom.wl_push(static_cast<data_t>(i));
+    sim_bus_t push = sim_bus;
+
+    // cold boot with head somewhere in the ring
+    sim_bus.reset();
+    WL_AT24CX<data_t, engine_t> reboot(0, 64, 0, num_of_data);
+    reboot.wl_init();
+    sim_bus_t init = sim_bus;
+    assert(reboot.wl_get_last_data() == static_cast<data_t>(pushes - 1));
+
+    uint32_t wear = sim_eeprom[0].max_wear(0, eeprom.get_end_addr());
+
+    printf(
+        "%-8s %-10s %6u slots | %7.2f bytes/push %5.2f cycles/push | init %5llu bytes %4llu xfers %8.2f ms | "
+        "%.3g pushes to wear-out\n",
+        name,
+        sizeof(data_t) == 2 ? "uint16_t" : (sizeof(data_t) == 4 ? "uint32_t" : "double"),
+        num_of_data,
+        1.0 * push.cell_writes / pushes,
+        1.0 * push.write_cycles / pushes,
+        (unsigned long long)(init.tx_bytes + init.rx_bytes),
+        (unsigned long long)init.transactions,
+        init.time_ns / 1e6,
+        1.0 * endurance * pushes / wear);
+}
+
+int main()
+{
+    printf("region %u bytes, %u pushes, %u cycles endurance\n", region_size, pushes, endurance);
+
+    bench<uint16_t, wl_engine_ptr>("ptr", sizeof(wl_data_t<uint16_t>));
+    bench<uint16_t, wl_engine_avr101>("avr101", sizeof(uint16_t) + 1);
+    bench<uint32_t, wl_engine_ptr>("ptr", sizeof(wl_data_t<uint32_t>));
+    bench<uint32_t, wl_engine_avr101>("avr101", sizeof(uint32_t) + 1);
+    bench<double, wl_engine_ptr>("ptr", sizeof(wl_data_t<double>));
+    bench<double, wl_engine_avr101>("avr101", sizeof(double) + 1);
+
+    return 0;
+}
@@ -0,0 +1,185 @@
+/**
+ * @file wl_idf_check.cpp
+ * @brief Host check of WL_AT24CX on the AT24CX_IDF backend, over the ESP-IDF I2C fake of extras/host
+ *
+ * ring: random pushes to a ring on AT24CX_IDF with reboots. Each reboot must recover the last value
+ * and pointer, and Wire must never be started.
+ * ack polling: the write cycle of the chip is set at random below AT24CX_WRITE_CYCLE. Every push must
+ * return once the chip ACKs again, not before and not a full AT24CX_WRITE_CYCLE later.
+ * bulk: a long read must move up to AT24CX_IDF_MAX_READ bytes per transfer and read back what was
+ * written. A ring init must take fewer transactions than on the Wire buffer of the default backend,
+ * which must find the same last value.
+ * wire start: once the sketch started Wire and called AT24CX_I2C::begin(true), transfers on the Wire
+ * backend must not start it again. Runs before any other Wire transfer.
+ *
+ * Build and run from repository root:
+ *   g++ -std=gnu++11 -O2 -Iextras/host -I. AT24CX.cpp extras/host/Wire.cpp extras/host/i2c.cpp \
+ *       extras/wl_idf_check/wl_idf_check.cpp -o wl_idf_check && ./wl_idf_check [trials] [seed]
+ */
+#include <Wire.h>
+
+#include "AT24CX_IDF.h"
+#include "WL_AT24CX.h"
+
+static const uint32_t num_of_data = 300;
+
+typedef WL_AT24CX<uint32_t> ring_t;
+
+static uint32_t check_ring(uint32_t trials)
+{
+    uint32_t errors = 0, pushes = 0, last = 0, ptr = 0;
+    sim_eeprom[0].erase();
+    sim_bus.reset();
+    AT24CX_IDF idf(I2C_NUM_0, 0, 64);
+
+    for (uint32_t t = 0; t < trials; t++) {
+        {
+            ring_t ring(0, 64, 0, num_of_data);
+            ring.setBackend(&idf);
+            ring.wl_init3();
+            errors += ring.wl_get_ptr() != ptr;
+            uint32_t n = rand() % 16;
+            for (uint32_t i = 0; i < n; i++, pushes++) {
+                last = rand();
+                ring.wl_push(last);
+            }
+            ptr = ring.wl_get_ptr();
+        }
+
+        ring_t reboot(0, 64, 0, num_of_data);
+        reboot.setBackend(&idf);
+        reboot.wl_init3();
+        errors += reboot.wl_get_ptr() != ptr || (pushes > 0 && reboot.wl_get_last_data() != last);
+    }
+
+    printf("ring        %u boots, %u pushes, Wire started %u times: %u errors\n", trials, pushes, Wire.begins, errors);
+    return errors + (Wire.begins != 0);
+}
+
+static uint32_t check_ack_polling(uint32_t trials)
+{
+    uint32_t early = 0, late = 0;
+    uint64_t idf_ns = 0, wire_ns = 0;
+    sim_eeprom[0].erase();
+    sim_bus.reset();
+    AT24CX_IDF idf(I2C_NUM_0, 0, 64);
+    ring_t ring(0, 64, 0, num_of_data);
+    ring.setBackend(&idf);
+    ring.wl_init3();
+
+    for (uint32_t t = 0; t < trials; t++) {
+        sim_eeprom[0].write_cycle_ns = 1000000 + rand() % (AT24CX_WRITE_CYCLE - 2) * 1000000ULL;
+        uint64_t start               = sim_bus.time_ns;
+        ring.wl_push(t);
+        idf_ns += sim_bus.time_ns - start;
+
+        // a push returns after the first probe the chip ACKs, polled at most every probe transfer
+        early += sim_bus.time_ns < sim_eeprom[0].busy_until_ns;
+        late += sim_bus.time_ns > sim_eeprom[0].busy_until_ns + 1000000;
+    }
+    sim_eeprom[0].write_cycle_ns = 5000000;
+
+    ring_t wire(0, 64, 0, num_of_data);
+    wire.wl_init3();
+    for (uint32_t t = 0; t < trials; t++) {
+        uint64_t start = sim_bus.time_ns;
+        wire.wl_push(t);
+        wire_ns += sim_bus.time_ns - start;
+    }
+
+    printf(
+        "ack polling %u pushes, %.2f ms per push against %.2f ms on Wire, %u returned early, %u late\n",
+        trials,
+        idf_ns / 1e6 / trials,
+        wire_ns / 1e6 / trials,
+        early,
+        late);
+    return early + late;
+}
+
+static uint32_t check_bulk()
+{
+    static byte data[20000], out[sizeof(data)];
+    uint32_t errors = 0;
+    sim_eeprom[0].erase();
+    sim_bus.reset();
+    AT24CX_IDF idf(I2C_NUM_0, 0, 64);
+
+    AT24CX chip(0, 64);
+    chip.setBackend(&idf);
+    for (uint32_t i = 0; i < sizeof(data); i++)
+        data[i] = rand();
+    chip.write(100, data, sizeof(data));
+    sim_bus.reset();
+    chip.read(100, out, sizeof(out));
+    errors += memcmp(data, out, sizeof(data)) != 0;
+    uint64_t idf_reads = sim_bus.transactions;
+
+    // address write and read per transfer
+    uint64_t transfers = (sizeof(data) + AT24CX_IDF_MAX_READ - 1) / AT24CX_IDF_MAX_READ;
+    errors += idf_reads != 2 * transfers;
+
+    ring_t ring(0, 64, 0, num_of_data);
+    ring.setBackend(&idf);
+    ring.wipe();
+    ring.wl_init3();
+    for (uint32_t i = 0; i < num_of_data + 7; i++)
+        ring.wl_push(i);
+
+    ring_t idf_boot(0, 64, 0, num_of_data);
+    idf_boot.setBackend(&idf);
+    sim_bus.reset();
+    idf_boot.wl_init3();
+    uint64_t idf_init = sim_bus.transactions;
+
+    ring_t wire_boot(0, 64, 0, num_of_data);
+    sim_bus.reset();
+    wire_boot.wl_init3();
+    uint64_t wire_init = sim_bus.transactions;
+    errors += idf_boot.wl_get_last_data() != num_of_data + 6 || wire_boot.wl_get_last_data() != num_of_data + 6;
+    errors += idf_init >= wire_init;
+
+    printf(
+        "bulk        %u bytes read in %llu transactions, ring init %llu transactions against %llu on Wire: %u errors\n",
+        (uint32_t)sizeof(data),
+        (unsigned long long)idf_reads,
+        (unsigned long long)idf_init,
+        (unsigned long long)wire_init,
+        errors);
+    return errors;
+}
+
+static uint32_t check_wire_start()
+{
+    sim_eeprom[0].erase();
+    sim_bus.reset();
+    Wire.begins = 0;
+
+    // sketch setup(): Wire.begin(), Wire.setClock(), then tell the library
+    Wire.begin();
+    AT24CX_I2C::begin(true);
+
+    ring_t ring(0, 64, 0, num_of_data);
+    ring.wl_init3();
+    ring.wl_push(1);
+    uint32_t begins = Wire.begins;
+
+    printf("wire start  Wire started %u times by the sketch and the library\n", begins);
+    return begins != 1;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t trials = argc > 1 ? strtoul(argv[1], nullptr, 0) : 300;
+    uint32_t seed   = argc > 2 ? strtoul(argv[2], nullptr, 0) : 1;
+    srand(seed);
+
+    uint32_t failures = 0;
+    failures += check_ring(trials);
+    failures += check_wire_start();
+    failures += check_ack_polling(trials);
+    failures += check_bulk();
+
+    printf("%s, %u failures\n", failures ? "FAIL" : "PASS", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,129 @@
+/**
+ * @file wl_init_chip_check.cpp
+ * @brief Host check of wl_init_chip() against wl_init3() per ring on a simulated AT24C256
+ *
+ * Three rings of different record sizes share a chip, chained with get_end_addr() or with a gap after
+ * the first one, so records straddle the sweep chunks. Every trial pushes a random number of values to
+ * each ring, from a random start pointer so some rings wrap, and sometimes cuts power inside a push.
+ * After reboot wl_init_chip() must give every ring the same pointer and last data as wl_init3(),
+ * and that last data must be the last value pushed, or the interrupted one.
+ * The bus transactions of both inits are summed.
+ *
+ * Build and run from repository root:
+ *   g++ -std=gnu++11 -O2 -Iextras/host -I. AT24CX.cpp extras/host/Wire.cpp \
+ *       extras/wl_init_chip_check/wl_init_chip_check.cpp -o wl_init_chip_check && ./wl_init_chip_check [trials] [seed]
+ */
+#include <Wire.h>
+
+#include "WL_AT24CX.h"
+
+typedef WL_AT24CX<uint32_t> ring_a_t;
+typedef WL_AT24CX<double> ring_b_t;
+typedef WL_AT24CX<uint16_t> ring_c_t;
+
+static const uint32_t slots_a = 37, slots_b = 21, slots_c = 50;
+
+/**
+ * @brief the three rings of one boot, ring a at base 0, gap bytes between ring a and ring b
+ */
+struct chip_t {
+    ring_a_t a;
+    ring_b_t b;
+    ring_c_t c;
+
+    explicit chip_t(uint32_t gap)
+        : a(0, 64, 0, slots_a),
+          b(0, 64, a.get_end_addr() + gap, slots_b),
+          c(0, 64, b.get_end_addr(), slots_c)
+    {
+    }
+};
+
+/**
+ * @brief push a random number of values
+ *
+ * @param last last value pushed
+ * @return true if anything was pushed
+ */
+template <class ring_t, class data_t>
+static bool fill(ring_t &ring, uint32_t slots, data_t &last)
+{
+    ring.wl_init3();
+    if (rand() % 2)
+        ring.wl_set_ptr(0xFFFFFFFE - rand() % slots); // pushes may run through pointer wraparound
+    uint32_t pushes = rand() % (3 * slots);
+    for (uint32_t i = 0; i < pushes; i++) {
+        last = rand();
+        ring.wl_push(last);
+    }
+    return pushes > 0;
+}
+
+template <class ring_t>
+static uint32_t compare(ring_t &swept, ring_t &scanned)
+{
+    if (swept.wl_get_ptr() != scanned.wl_get_ptr())
+        return 1;
+    return swept.wl_get_ptr() > 0 && swept.wl_get_last_data() != scanned.wl_get_last_data();
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t trials = argc > 1 ? strtoul(argv[1], nullptr, 0) : 3000;
+    uint32_t seed   = argc > 2 ? strtoul(argv[2], nullptr, 0) : 1;
+    srand(seed);
+
+    uint32_t mismatches = 0, wrong = 0, cuts = 0;
+    uint64_t per_ring = 0, swept = 0;
+    for (uint32_t t = 0; t < trials; t++) {
+        uint32_t gap = (rand() % 2) ? 0 : rand() % 100;
+        uint32_t last_a = 0;
+        double last_b = 0, cut_b = -1;
+        uint16_t last_c = 0;
+        bool pushed_a, pushed_b, pushed_c;
+        sim_eeprom[0].erase();
+        sim_bus.reset();
+        {
+            chip_t chip(gap);
+            pushed_a = fill(chip.a, slots_a, last_a);
+            pushed_b = fill(chip.b, slots_b, last_b);
+            pushed_c = fill(chip.c, slots_c, last_c);
+            if (rand() % 2) {
+                cut_b = rand();
+                sim_bus.arm_power_cut(rand() % sizeof(ring_b_t::record_t), rand() % 2);
+                chip.b.wl_push(cut_b);
+                cuts++;
+            }
+        }
+        sim_bus.restore_power();
+
+        chip_t scanned(gap);
+        sim_bus.reset();
+        scanned.a.wl_init3();
+        scanned.b.wl_init3();
+        scanned.c.wl_init3();
+        per_ring += sim_bus.transactions;
+
+        chip_t chip(gap);
+        sim_bus.reset();
+        wl_init_chip(chip.a, chip.b, chip.c);
+        swept += sim_bus.transactions;
+
+        mismatches += compare(chip.a, scanned.a) + compare(chip.b, scanned.b) + compare(chip.c, scanned.c);
+        wrong += pushed_a && chip.a.wl_get_last_data() != last_a;
+        wrong += pushed_b && chip.b.wl_get_last_data() != last_b && chip.b.wl_get_last_data() != cut_b;
+        wrong += pushed_c && chip.c.wl_get_last_data() != last_c;
+    }
+
+    printf(
+        "%u trials, %u power cuts: %u rings differ from wl_init3, %u wrong last data, %.1f transactions per boot against %.1f\n",
+        trials,
+        cuts,
+        mismatches,
+        wrong,
+        (double)swept / trials,
+        (double)per_ring / trials);
+    uint32_t failures = mismatches + wrong;
+    printf("%s, %u failures\n", failures ? "FAIL" : "PASS", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,175 @@
+/**
+ * @file wl_kv_check.cpp
+ * @brief Host check of WL_KV_AT24CX compaction, idle service wear and power-cut recovery
+ *
+ * compaction: random puts against a RAM model, every key is compared after each reboot.
+ * idle: the store is filled, then kv_service() is called 1000 times with no put, no write may happen.
+ * power cut: power fails at a random byte of a put, torn or not. After reboot every other key must
+ * hold its last value and the key being put its old or its new value.
+ *
+ * Build and run from repository root:
+ *   g++ -std=gnu++11 -O2 -Iextras/host -I. AT24CX.cpp extras/host/Wire.cpp \
+ *       extras/wl_kv_check/wl_kv_check.cpp -o wl_kv_check && ./wl_kv_check [trials] [seed]
+ */
+#include <Wire.h>
+
+#include "WL_KV_AT24CX.h"
+
+static const uint32_t value_none = 0xFFFFFFFF; // key never put
+
+/**
+ * @brief compare every key of store against model
+ *
+ * @param skip key allowed to hold alt instead of its model value, max_keys for none
+ * @return uint32_t keys holding a wrong value
+ */
+template <size_t max_keys>
+static uint32_t compare(WL_KV_AT24CX<4, max_keys> &store, const uint32_t *model, uint32_t skip, uint32_t alt)
+{
+    uint32_t errors = 0;
+    for (uint32_t key = 0; key < max_keys; key++) {
+        uint32_t value = value_none;
+        store.kv_get(key, value);
+        if (value != model[key] && !(key == skip && value == alt))
+            errors++;
+    }
+    return errors;
+}
+
+template <size_t max_keys>
+static uint32_t check_compaction(uint32_t num_of_slots, uint32_t puts)
+{
+    uint32_t model[max_keys];
+    uint32_t errors = 0;
+    for (uint32_t &value : model)
+        value = value_none;
+
+    sim_eeprom[0].erase();
+    WL_KV_AT24CX<4, max_keys> store(0, 64, 0, num_of_slots);
+    store.kv_init();
+    for (uint32_t i = 0; i < puts; i++) {
+        uint32_t key = rand() % max_keys;
+        model[key]   = rand();
+        store.kv_put(key, model[key]);
+        if (rand() % 2)
+            store.kv_service();
+
+        if (i % 50 == 0) {
+            WL_KV_AT24CX<4, max_keys> reboot(0, 64, 0, num_of_slots);
+            reboot.kv_init();
+            errors += compare(reboot, model, max_keys, 0);
+        }
+    }
+
+    printf("compaction %3u slots %3u keys: %u puts, %u errors\n", num_of_slots, (uint32_t)max_keys, puts, errors);
+    return errors;
+}
+
+template <size_t max_keys>
+static uint32_t check_idle(uint32_t num_of_slots)
+{
+    sim_eeprom[0].erase();
+    WL_KV_AT24CX<4, max_keys> store(0, 64, 0, num_of_slots);
+    store.kv_init();
+    for (uint32_t i = 0; i < 4 * num_of_slots; i++)
+        store.kv_put(i % max_keys, i);
+
+    // let service reach its steady state, then count writes of idle calls
+    for (uint32_t i = 0; i < num_of_slots; i++)
+        store.kv_service();
+    sim_bus.reset();
+    for (uint32_t i = 0; i < 1000; i++)
+        store.kv_service();
+
+    printf(
+        "idle       %3u slots %3u keys: 1000 kv_service() calls, %llu write cycles\n",
+        num_of_slots,
+        (uint32_t)max_keys,
+        (unsigned long long)sim_bus.write_cycles);
+    return sim_bus.write_cycles > 0;
+}
+
+template <size_t max_keys>
+static uint32_t check_power_cut(uint32_t num_of_slots, uint32_t trials)
+{
+    const uint32_t record_size = sizeof(kv_record_t<4>);
+    uint32_t garbage = 0, stale = 0, lost = 0;
+
+    for (uint32_t t = 0; t < trials; t++) {
+        uint32_t model[max_keys];
+        for (uint32_t &value : model)
+            value = value_none;
+
+        sim_eeprom[0].erase();
+        sim_bus.reset();
+        uint32_t key, value;
+        {
+            WL_KV_AT24CX<4, max_keys> store(0, 64, 0, num_of_slots);
+            store.kv_init();
+            uint32_t puts = rand() % (6 * num_of_slots);
+            for (uint32_t i = 0; i < puts; i++) {
+                key        = rand() % max_keys;
+                model[key] = rand();
+                store.kv_put(key, model[key]);
+            }
+
+            // a put may compact first, the cut can hit any of its writes
+            key   = rand() % max_keys;
+            value = rand();
+            sim_bus.arm_power_cut(rand() % (3 * record_size), rand() % 2);
+            store.kv_put(key, value);
+        }
+        bool completed = !sim_bus.power_lost;
+        sim_bus.restore_power();
+        if (completed)
+            model[key] = value;
+
+        WL_KV_AT24CX<4, max_keys> reboot(0, 64, 0, num_of_slots);
+        reboot.kv_init();
+        for (uint32_t k = 0; k < max_keys; k++) {
+            uint32_t got = value_none;
+            reboot.kv_get(k, got);
+            if (got == model[k] || (k == key && got == value))
+                continue;
+            bool known = false;
+            for (uint32_t j = 0; j < max_keys; j++)
+                known = known || got == model[j];
+            if (got == value_none)
+                lost++;
+            else if (known)
+                stale++;
+            else
+                garbage++;
+        }
+    }
+
+    printf(
+        "power cut  %3u slots %3u keys: %u trials, %u garbage, %u stale, %u lost keys\n",
+        num_of_slots,
+        (uint32_t)max_keys,
+        trials,
+        garbage,
+        stale,
+        lost);
+    return garbage + stale + lost;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t trials = argc > 1 ? strtoul(argv[1], nullptr, 0) : 3000;
+    uint32_t seed   = argc > 2 ? strtoul(argv[2], nullptr, 0) : 1;
+    srand(seed);
+
+    uint32_t failures = 0;
+    failures += check_compaction<4>(6, 2000);
+    failures += check_compaction<16>(20, 2000);
+    failures += check_compaction<80>(100, 2000);
+    failures += check_idle<16>(20);
+    failures += check_idle<80>(100);
+    failures += check_idle<4>(40);
+    failures += check_power_cut<8>(12, trials);
+    failures += check_power_cut<16>(20, trials);
+
+    printf("%s, %u failures\n", failures ? "FAIL" : "PASS", failures);
+    return failures ? 1 : 0;
+}
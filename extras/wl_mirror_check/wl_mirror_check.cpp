@@ -0,0 +1,177 @@
+/**
+ * @file wl_mirror_check.cpp
+ * @brief Host power-cut check of WL_MIRROR_AT24CX with the rings on two simulated AT24C256
+ *
+ * Every trial pushes a random number of values, then cuts power at a random byte of the next push,
+ * in either ring, leaving the byte at the cut torn or untouched. After reboot the mirror must return
+ * the interrupted value or the last complete one, and both rings must agree after the resync.
+ * corrupt counts values that were never pushed, lost counts older values returned.
+ * wrap: one ring has wrapped its pointer to 0 while the other lags one push behind at 0xFFFFFFFE,
+ * the mirror must return the value of the wrapped ring and resync the other.
+ * swap: the second chip is replaced by an erased one after 13 pushes. The first boot copies the last
+ * record under the same pointer, the second boot must not write at all, and when the head of the
+ * first ring goes bad after that the mirror must still return the last value from the copy.
+ *
+ * Build and run from repository root:
+ *   g++ -std=gnu++11 -O2 -Iextras/host -I. AT24CX.cpp extras/host/Wire.cpp \
+ *       extras/wl_mirror_check/wl_mirror_check.cpp -o wl_mirror_check && ./wl_mirror_check [trials] [seed]
+ */
+#include <Wire.h>
+
+#include "WL_MIRROR_AT24CX.h"
+
+static const uint32_t num_of_data = 16;
+
+static uint32_t value_of(uint32_t i)
+{
+    return i * 2654435761u + 12345; // distinct for every push
+}
+
+template <class engine_t>
+static uint32_t check_power_cut(const char *name, uint32_t trials)
+{
+    typedef WL_MIRROR_AT24CX<uint32_t, engine_t> mirror_t;
+    const uint32_t record_size = sizeof(typename WL_AT24CX<uint32_t, engine_t>::record_t);
+    uint32_t corrupt = 0, lost = 0, diverged = 0;
+
+    for (uint32_t t = 0; t < trials; t++) {
+        uint32_t pushes = rand() % (4 * num_of_data);
+        sim_eeprom[0].erase();
+        sim_eeprom[1].erase();
+        sim_bus.reset();
+        {
+            mirror_t mirror(0, 0, 1, 0, 64, num_of_data);
+            mirror.wl_init();
+            for (uint32_t i = 0; i < pushes; i++)
+                mirror.wl_push(value_of(i));
+
+            sim_bus.arm_power_cut(rand() % (2 * record_size), rand() % 2);
+            mirror.wl_push(value_of(pushes));
+        }
+        sim_bus.restore_power();
+
+        mirror_t reboot(0, 0, 1, 0, 64, num_of_data);
+        reboot.wl_init();
+        uint32_t data = reboot.wl_get_last_data();
+        if (pushes > 0 && data != value_of(pushes) && data != value_of(pushes - 1)) {
+            bool known = false;
+            for (uint32_t i = 0; i < pushes; i++)
+                known = known || data == value_of(i);
+            known ? lost++ : corrupt++;
+        }
+
+        // resync must leave both rings on the same record, an empty ring has no last value
+        WL_AT24CX<uint32_t, engine_t> a(0, 64, 0, num_of_data);
+        WL_AT24CX<uint32_t, engine_t> b(1, 64, 0, num_of_data);
+        a.wl_init3();
+        b.wl_init3();
+        diverged += a.wl_get_ptr() != b.wl_get_ptr() || (a.wl_get_ptr() > 0 && a.wl_get_last_data() != b.wl_get_last_data());
+    }
+
+    printf("%-9s %u trials, %u corrupt, %u lost, %u diverged\n", name, trials, corrupt, lost, diverged);
+    return corrupt + lost + diverged;
+}
+
+/**
+ * @brief put ahead ring one push past pointer wraparound and the other one push behind it
+ */
+static uint32_t check_wrap(uint32_t ahead)
+{
+    sim_eeprom[0].erase();
+    sim_eeprom[1].erase();
+    {
+        WL_AT24CX<uint32_t, wl_engine_ptr_crc16> lead(ahead, 64, 0, num_of_data);
+        WL_AT24CX<uint32_t, wl_engine_ptr_crc16> lag(1 - ahead, 64, 0, num_of_data);
+        lead.wl_init3();
+        lag.wl_init3();
+        lead.wl_set_ptr(0xFFFFFFFD);
+        lag.wl_set_ptr(0xFFFFFFFD);
+        lead.wl_push(4);
+        lead.wl_push(5); // next pointer wraps to 0
+        lag.wl_push(4);  // next pointer 0xFFFFFFFE
+        lead.sync();
+        lag.sync();
+    }
+
+    WL_MIRROR_AT24CX<uint32_t> mirror(0, 0, 1, 0, 64, num_of_data);
+    mirror.wl_init();
+    uint32_t data = mirror.wl_get_last_data();
+
+    WL_AT24CX<uint32_t, wl_engine_ptr_crc16> a(0, 64, 0, num_of_data);
+    WL_AT24CX<uint32_t, wl_engine_ptr_crc16> b(1, 64, 0, num_of_data);
+    a.wl_init3();
+    b.wl_init3();
+
+    printf("wrap      ring %u ahead: last data %u, ptr %u / %u\n", ahead, data, a.wl_get_ptr(), b.wl_get_ptr());
+    return (data != 5) + (a.wl_get_ptr() != b.wl_get_ptr());
+}
+
+static uint32_t check_swap()
+{
+    typedef WL_MIRROR_AT24CX<uint32_t> mirror_t;
+    uint32_t failures = 0;
+
+    sim_eeprom[0].erase();
+    sim_eeprom[1].erase();
+    {
+        mirror_t mirror(0, 0, 1, 0, 64, num_of_data);
+        mirror.wl_init();
+        for (uint32_t i = 1; i <= 13; i++)
+            mirror.wl_push(i);
+    }
+    sim_eeprom[1].erase(); // replaced chip
+
+    {
+        mirror_t mirror(0, 0, 1, 0, 64, num_of_data);
+        mirror.wl_init();
+        failures += mirror.wl_get_last_data() != 13;
+    }
+
+    sim_bus.reset();
+    uint32_t ptr_a, ptr_b;
+    {
+        mirror_t mirror(0, 0, 1, 0, 64, num_of_data);
+        mirror.wl_init();
+        failures += mirror.wl_get_last_data() != 13;
+
+        WL_AT24CX<uint32_t, wl_engine_ptr_crc16> a(0, 64, 0, num_of_data);
+        WL_AT24CX<uint32_t, wl_engine_ptr_crc16> b(1, 64, 0, num_of_data);
+        a.wl_init3();
+        b.wl_init3();
+        ptr_a = a.wl_get_ptr();
+        ptr_b = b.wl_get_ptr();
+    }
+    uint64_t rewrites = sim_bus.write_cycles;
+    failures += rewrites != 0 || ptr_a != ptr_b;
+
+    // head of the first ring goes bad, the copy on the replaced chip must hold the same value
+    const uint32_t record_size = sizeof(WL_AT24CX<uint32_t, wl_engine_ptr_crc16>::record_t);
+    sim_eeprom[0].mem[12 * record_size] ^= 0x55; // record of value 13, pushed as ptr 12
+    uint32_t torn;
+    {
+        mirror_t reboot(0, 0, 1, 0, 64, num_of_data);
+        reboot.wl_init();
+        torn = reboot.wl_get_last_data();
+    }
+    failures += torn != 13;
+
+    printf("swap      ptr %u / %u after resync, %llu writes on the next boot, last data %u with a bad head\n", ptr_a, ptr_b, (unsigned long long)rewrites, torn);
+    return failures;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t trials = argc > 1 ? strtoul(argv[1], nullptr, 0) : 3000;
+    uint32_t seed   = argc > 2 ? strtoul(argv[2], nullptr, 0) : 1;
+    srand(seed);
+
+    // the XOR engine is reported for comparison only, the mirror defaults to the CRC engine
+    check_power_cut<wl_engine_ptr>("ptr", trials);
+    uint32_t failures = check_power_cut<wl_engine_ptr_crc16>("ptr_crc16", trials);
+    failures += check_wrap(0);
+    failures += check_wrap(1);
+    failures += check_swap();
+
+    printf("%s, %u failures\n", failures ? "FAIL" : "PASS", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,260 @@
+/**
+ * @file wl_power_cut.cpp
+ * @brief Host power-cut injection for WL_AT24CX recovery on a simulated AT24C256
+ *
+ * Every trial fills a ring with a random number of pushes, cuts power at a random byte of the next
+ * push, leaving the byte at the cut either untouched or torn, then reboots into one init algorithm.
+ * It records the recovered value, the records lost besides the interrupted one and the slot reads
+ * init needed. The recovered ring then takes one more push and must return it after another reboot.
+ * Recovery runs in a child process, so an init that asserts is counted instead of ending the run.
+ *
+ * Columns: survived = interrupted push recovered, kept = last complete push recovered,
+ * lost = trials that lost complete pushes (max_lost the worst), corrupt = value never pushed,
+ * ptr_err = next pointer does not follow the recovered record, resume = push after recovery lost,
+ * aborted = init asserted, reads = slot reads by init, ms = simulated init time.
+ *
+ * The crc false-accept rate is measured apart: a one-slot ring holding a random record is overwritten
+ * by another random record with power cut at a random byte, torn. A slot that then passes the check
+ * while holding neither record counts as accepted.
+ *
+ * Build and run from repository root:
+ *   g++ -std=gnu++11 -O2 -Iextras/host -I. AT24CX.cpp extras/host/Wire.cpp \
+ *       extras/wl_power_cut/wl_power_cut.cpp -o wl_power_cut && ./wl_power_cut [trials] [seed]
+ */
+#include <Wire.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "WL_AT24CX.h"
+
+static const uint32_t num_of_data = 32;
+
+struct result_t {
+    uint32_t trials;
+    uint32_t survived;    // interrupted push was recovered
+    uint32_t kept;        // last complete push was recovered
+    uint32_t lost;        // trials that lost complete pushes
+    uint32_t lost_max;    // most complete pushes lost in one trial
+    uint32_t corrupt;     // recovered value was never pushed
+    uint32_t ptr_errors;  // next pointer does not follow the recovered record
+    uint32_t resume_errors;
+    uint32_t aborted;     // init crashed or asserted
+    uint64_t reads_total; // slot reads during init
+    uint32_t reads_max;
+    uint64_t ns_max;      // init time
+};
+
+static uint32_t value_of(uint32_t i)
+{
+    return i * 2654435761u + 12345; // distinct for every push
+}
+
+template <class engine_t>
+static void init(WL_AT24CX<uint32_t, engine_t> &ring, int algorithm)
+{
+    if (algorithm == 1)
+        ring.wl_init();
+    else if (algorithm == 2)
+        ring.wl_init2();
+    else
+        ring.wl_init3();
+}
+
+/**
+ * @brief outcome of one recovery, sent from the child process
+ */
+struct outcome_t {
+    bool survived;
+    bool kept;
+    bool corrupt;
+    bool ptr_error;
+    bool resume_error;
+    uint32_t lost;
+    uint32_t reads;
+    uint64_t ns;
+};
+
+template <class engine_t>
+static outcome_t recover(int algorithm, uint32_t pushes)
+{
+    const uint32_t record_size = sizeof(typename WL_AT24CX<uint32_t, engine_t>::record_t);
+    outcome_t out              = {};
+
+    sim_bus.reset();
+    WL_AT24CX<uint32_t, engine_t> ring(0, 64, 0, num_of_data);
+    init(ring, algorithm);
+
+    out.reads = (sim_bus.rx_bytes + record_size - 1) / record_size;
+    out.ns    = sim_bus.time_ns;
+
+    // index of recovered push, pushes means the interrupted one
+    uint32_t data = ring.wl_get_last_data();
+    int64_t found = -1;
+    for (uint32_t i = 0; i <= pushes; i++) {
+        if (value_of(i) == data)
+            found = i;
+    }
+
+    if (pushes == 0 && ring.wl_get_ptr() == 0) {
+        out.kept = true; // empty ring recovered as empty, last data is not meaningful
+    } else if (found == pushes) {
+        out.survived = true;
+    } else if (found >= 0) {
+        out.lost = pushes - 1 - found;
+        out.kept = out.lost == 0;
+    } else {
+        out.corrupt = true;
+    }
+
+    if (!out.kept && found >= 0 && ring.wl_get_ptr() != found + 1)
+        out.ptr_error = true;
+
+    // recovered ring must keep working
+    ring.wl_push(value_of(pushes + 1));
+    WL_AT24CX<uint32_t, engine_t> reboot(0, 64, 0, num_of_data);
+    init(reboot, algorithm);
+    out.resume_error = reboot.wl_get_last_data() != value_of(pushes + 1);
+
+    return out;
+}
+
+template <class engine_t>
+static void trial(int algorithm, result_t &result)
+{
+    const uint32_t record_size = sizeof(typename WL_AT24CX<uint32_t, engine_t>::record_t);
+    uint32_t pushes            = rand() % (4 * num_of_data); // complete pushes before the cut
+
+    sim_eeprom[0].erase();
+    sim_bus.reset();
+    {
+        WL_AT24CX<uint32_t, engine_t> ring(0, 64, 0, num_of_data);
+        ring.wl_init2();
+        for (uint32_t i = 0; i < pushes; i++)
+            ring.wl_push(value_of(i));
+
+        sim_bus.arm_power_cut(rand() % record_size, rand() % 2);
+        ring.wl_push(value_of(pushes));
+    }
+
+    // reboot in a child, it may assert
+    int fd[2];
+    outcome_t out = {};
+    bool ok       = false;
+    if (pipe(fd) != 0) {
+        perror("pipe");
+        exit(1);
+    }
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(fd[0]);
+        freopen("/dev/null", "w", stderr); // assert messages are counted, not printed
+        out = recover<engine_t>(algorithm, pushes);
+        ssize_t written = write(fd[1], &out, sizeof(out));
+        _exit(written == sizeof(out) ? 0 : 1);
+    }
+    close(fd[1]);
+    ok = read(fd[0], &out, sizeof(out)) == sizeof(out);
+    close(fd[0]);
+    int status;
+    waitpid(pid, &status, 0);
+    ok = ok && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+
+    result.trials++;
+    if (!ok) {
+        result.aborted++;
+        return;
+    }
+
+    result.reads_total += out.reads;
+    result.reads_max = max(result.reads_max, out.reads);
+    result.ns_max    = max(result.ns_max, out.ns);
+    result.survived += out.survived;
+    result.kept += out.kept;
+    result.corrupt += out.corrupt;
+    result.ptr_errors += out.ptr_error;
+    result.resume_errors += out.resume_error;
+    if (!out.survived && !out.kept && !out.corrupt) {
+        result.lost++;
+        result.lost_max = max(result.lost_max, out.lost);
+    }
+}
+
+template <class engine_t>
+static void run(const char *name, uint32_t trials)
+{
+    for (int algorithm = 1; algorithm <= 3; algorithm++) {
+        result_t result = {};
+        for (uint32_t i = 0; i < trials; i++)
+            trial<engine_t>(algorithm, result);
+
+        printf(
+            "%-9s wl_init%d %7u %8u %6u %6u %8u %7u %7u %6u %7u %9.1f %9u %8.2f\n",
+            name,
+            algorithm,
+            result.trials,
+            result.survived,
+            result.kept,
+            result.lost,
+            result.lost_max,
+            result.corrupt,
+            result.ptr_errors,
+            result.resume_errors,
+            result.aborted,
+            1.0 * result.reads_total / result.trials,
+            result.reads_max,
+            result.ns_max / 1e6);
+    }
+}
+
+template <class engine_t>
+static void false_accepts(const char *name, uint32_t trials)
+{
+    typedef typename WL_AT24CX<uint32_t, engine_t>::record_t record_t;
+    uint32_t torn = 0, accepted = 0;
+
+    sim_eeprom[0].erase();
+    WL_AT24CX<uint32_t, engine_t> ring(0, 64, 0, 1);
+    ring.wl_init3();
+    for (uint32_t i = 0; i < trials; i++) {
+        sim_bus.reset();
+        ring.wl_set_ptr(((uint32_t)rand() << 16) ^ rand());
+        uint32_t old_ptr  = ring.wl_get_ptr();
+        uint32_t old_data = ((uint32_t)rand() << 16) ^ rand();
+        uint32_t new_data = ((uint32_t)rand() << 16) ^ rand();
+        ring.wl_push(old_data);
+        uint32_t new_ptr = ring.wl_get_ptr();
+
+        sim_bus.arm_power_cut(rand() % sizeof(record_t), true);
+        ring.wl_push(new_data);
+        sim_bus.restore_power();
+
+        record_t record = ring.wl_peek(0);
+        bool is_old     = record.data == old_data && record.ptr == old_ptr;
+        bool is_new     = record.data == new_data && record.ptr == new_ptr;
+        if (is_old || is_new)
+            continue;
+        torn++;
+        accepted += ring.wl_isvalid(record);
+    }
+
+    printf("%-9s %u of %u torn records pass the crc (%.5f%%)\n", name, accepted, torn, 100.0 * accepted / torn);
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t trials = argc > 1 ? strtoul(argv[1], nullptr, 0) : 2000;
+    uint32_t seed   = argc > 2 ? strtoul(argv[2], nullptr, 0) : 1;
+    srand(seed);
+
+    printf("%u slots, %u trials per algorithm, seed %u\n", num_of_data, trials, seed);
+    printf(
+        "engine    init      trials survived   kept   lost max_lost corrupt ptr_err resume aborted reads_avg reads_max   ms_max\n");
+    run<wl_engine_ptr>("ptr", trials);
+    run<wl_engine_ptr_crc16>("ptr_crc16", trials);
+
+    printf("\ncrc false accepts\n");
+    false_accepts<wl_engine_ptr>("ptr", 100 * trials);
+    false_accepts<wl_engine_ptr_crc16>("ptr_crc16", 100 * trials);
+
+    return 0;
+}
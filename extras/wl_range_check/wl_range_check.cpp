@@ -0,0 +1,123 @@
+/**
+ * @file wl_range_check.cpp
+ * @brief Host check of the range read_mem/write_mem of wl_engine_plain on a simulated AT24C256
+ *
+ * table: a 512-entry uint16_t table is written and read back once per element and once as a range,
+ * the bus cost of both is printed. The simulated chip wraps writes at page boundaries like the real one,
+ * so a write that is not split per page corrupts the table.
+ * wrap: random ranges of random length, crossing the end of the array and unaligned to pages, are written
+ * over a RAM model and read back. Bytes around the array must keep their sentinel value.
+ *
+ * Build and run from repository root:
+ *   g++ -std=gnu++11 -O2 -Iextras/host -I. AT24CX.cpp extras/host/Wire.cpp \
+ *       extras/wl_range_check/wl_range_check.cpp -o wl_range_check && ./wl_range_check [trials] [seed]
+ */
+#include <Wire.h>
+
+#include "WL_AT24CX.h"
+
+static const uint32_t num_of_data = 512;
+static const uint32_t base_addr   = 37; // not page aligned
+static const uint8_t sentinel     = 0xA5;
+
+typedef WL_AT24CX<uint16_t, wl_engine_plain> table_t;
+
+static uint32_t check_sentinels()
+{
+    uint32_t end = base_addr + num_of_data * sizeof(uint16_t);
+    return (sim_eeprom[0].mem[base_addr - 1] != sentinel) + (sim_eeprom[0].mem[end] != sentinel);
+}
+
+static void erase_with_sentinels()
+{
+    sim_eeprom[0].erase();
+    sim_eeprom[0].mem[base_addr - 1]                              = sentinel;
+    sim_eeprom[0].mem[base_addr + num_of_data * sizeof(uint16_t)] = sentinel;
+}
+
+static uint32_t check_table()
+{
+    uint16_t table[num_of_data], out[num_of_data];
+    uint32_t errors = 0;
+    for (uint32_t i = 0; i < num_of_data; i++)
+        table[i] = i * 31 + 7;
+
+    erase_with_sentinels();
+    table_t array(0, 64, base_addr, num_of_data);
+
+    sim_bus.reset();
+    for (uint32_t i = 0; i < num_of_data; i++)
+        array.write_mem(i, table[i]);
+    uint64_t single_writes = sim_bus.write_cycles;
+    sim_bus.reset();
+    for (uint32_t i = 0; i < num_of_data; i++)
+        errors += array.read_mem(i) != table[i];
+    uint64_t single_reads = sim_bus.transactions;
+
+    erase_with_sentinels();
+    sim_bus.reset();
+    array.write_mem(0, table, num_of_data);
+    uint64_t range_writes = sim_bus.write_cycles;
+    sim_bus.reset();
+    array.read_mem(0, out, num_of_data);
+    uint64_t range_reads = sim_bus.transactions;
+    for (uint32_t i = 0; i < num_of_data; i++)
+        errors += out[i] != table[i];
+    errors += check_sentinels();
+
+    printf(
+        "table %u x uint16_t: write %llu -> %llu write cycles, read %llu -> %llu transactions, %u errors\n",
+        num_of_data,
+        (unsigned long long)single_writes,
+        (unsigned long long)range_writes,
+        (unsigned long long)single_reads,
+        (unsigned long long)range_reads,
+        errors);
+    return errors;
+}
+
+static uint32_t check_wrap(uint32_t trials)
+{
+    uint16_t model[num_of_data], buffer[num_of_data];
+    uint32_t errors = 0, wrapped = 0;
+
+    erase_with_sentinels();
+    table_t array(0, 64, base_addr, num_of_data);
+    for (uint32_t i = 0; i < num_of_data; i++)
+        model[i] = 0xFFFF;
+
+    for (uint32_t t = 0; t < trials; t++) {
+        uint32_t start = rand() % (2 * num_of_data); // taddr beyond num_of_data wraps too
+        uint32_t count = 1 + rand() % num_of_data;
+        for (uint32_t i = 0; i < count; i++) {
+            buffer[i]                        = rand();
+            model[(start + i) % num_of_data] = buffer[i];
+        }
+        wrapped += start % num_of_data + count > num_of_data;
+        array.write_mem(start, buffer, count);
+
+        uint32_t rstart = rand() % num_of_data;
+        uint32_t rcount = 1 + rand() % num_of_data;
+        array.read_mem(rstart, buffer, rcount);
+        for (uint32_t i = 0; i < rcount; i++)
+            errors += buffer[i] != model[(rstart + i) % num_of_data];
+    }
+    errors += check_sentinels();
+
+    printf("wrap  %u random ranges, %u across the end: %u errors\n", trials, wrapped, errors);
+    return errors;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t trials = argc > 1 ? strtoul(argv[1], nullptr, 0) : 3000;
+    uint32_t seed   = argc > 2 ? strtoul(argv[2], nullptr, 0) : 1;
+    srand(seed);
+
+    uint32_t failures = 0;
+    failures += check_table();
+    failures += check_wrap(trials);
+
+    printf("%s, %u failures\n", failures ? "FAIL" : "PASS", failures);
+    return failures ? 1 : 0;
+}
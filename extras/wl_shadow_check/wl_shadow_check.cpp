@@ -0,0 +1,159 @@
+/**
+ * @file wl_shadow_check.cpp
+ * @brief Host check of the RAM shadow and the power-fail flush of WL_AT24CX on a simulated AT24C256
+ *
+ * shadow: pushes at random gaps into a ring with a RAM shadow, wl_service() called at random.
+ * wl_get_last_data() must always return the last push, eeprom may only be written by wl_service()
+ * once the period passed since the first uncommitted push, and after the period and wl_service()
+ * a reboot must find the last push.
+ * power fail: three rings with shadow, group commit or both, and one more ring not registered, take
+ * random pushes. wl_power_fail_notify() then wl_power_fail_service() must commit every registered
+ * ring with the page writes wl_pending_writes() announced, and leave the unregistered one alone.
+ * A registered ring that goes out of scope must leave the list.
+ *
+ * Build and run from repository root:
+ *   g++ -std=gnu++11 -O2 -Iextras/host -I. AT24CX.cpp extras/host/Wire.cpp \
+ *       extras/wl_shadow_check/wl_shadow_check.cpp -o wl_shadow_check && ./wl_shadow_check [trials] [seed]
+ */
+#include <Wire.h>
+
+#include "WL_AT24CX.h"
+
+static const uint32_t num_of_data = 30;
+static const uint32_t period_ms   = 100;
+
+typedef WL_AT24CX<uint32_t> ring_t;
+
+static uint32_t stored(uint32_t base, uint32_t &ptr)
+{
+    ring_t reboot(0, 64, base, num_of_data);
+    reboot.wl_init3();
+    ptr = reboot.wl_get_ptr();
+    return reboot.wl_get_last_data();
+}
+
+static uint32_t check_shadow(uint32_t trials)
+{
+    uint32_t errors = 0, early = 0, lost = 0, pushes = 0, commits = 0;
+    for (uint32_t t = 0; t < trials; t++) {
+        sim_eeprom[0].erase();
+        sim_bus.reset();
+        ring_t ring(0, 64, 0, num_of_data);
+        ring.wl_init3();
+        ring.wl_shadow(period_ms);
+
+        uint32_t last = 0, ptr;
+        unsigned long first_ms = 0; // first push since last commit
+        bool pending           = false;
+        uint32_t n             = 1 + rand() % 40;
+        for (uint32_t i = 0; i < n; i++, pushes++) {
+            delay(rand() % 50);
+            if (!pending)
+                first_ms = millis();
+            last    = rand();
+            pending = true;
+
+            uint64_t writes = sim_bus.write_cycles;
+            ring.wl_push(last);
+            errors += sim_bus.write_cycles != writes || ring.wl_get_last_data() != last;
+
+            if (rand() % 3 == 0) {
+                ring.wl_service();
+                bool due = millis() - first_ms >= period_ms;
+                early += sim_bus.write_cycles != writes && !due;
+                if (sim_bus.write_cycles != writes) {
+                    commits++;
+                    pending = false;
+                }
+                lost += due && stored(0, ptr) != last;
+            }
+        }
+
+        delay(period_ms);
+        ring.wl_service();
+        lost += stored(0, ptr) != last || ptr != ring.wl_get_ptr();
+    }
+
+    printf("shadow      %u pushes, %u commits, %u before the period, %u lost after it: %u errors\n", pushes, commits, early, lost, errors);
+    return errors + early + lost;
+}
+
+static uint32_t check_power_fail(uint32_t trials)
+{
+    uint32_t errors = 0, misses = 0, lost = 0, kept = 0;
+    for (uint32_t t = 0; t < trials; t++) {
+        sim_eeprom[0].erase();
+        sim_bus.reset();
+
+        ring_t a(0, 64, 0, num_of_data);
+        ring_t b(0, 64, a.get_end_addr(), num_of_data);
+        ring_t c(0, 64, b.get_end_addr(), num_of_data);
+        ring_t d(0, 64, c.get_end_addr(), num_of_data);
+        ring_t *rings[] = {&a, &b, &c, &d};
+        uint32_t last[4] = {0}, first[4] = {0};
+        for (ring_t *ring : rings)
+            ring->wl_init3();
+        a.wl_shadow(60000);
+        b.wl_group_commit(8);
+        c.wl_shadow(60000);
+        c.wl_group_commit(8);
+        d.wl_shadow(60000); // not registered
+        a.wl_power_fail_register();
+        b.wl_power_fail_register();
+        c.wl_power_fail_register();
+        {
+            // goes away registered, the list must not keep it
+            ring_t gone(0, 64, d.get_end_addr(), num_of_data);
+            gone.wl_init3();
+            gone.wl_power_fail_register();
+        }
+
+        for (uint32_t r = 0; r < 4; r++) {
+            first[r] = rand();
+            rings[r]->wl_push(first[r]);
+            rings[r]->flush();
+            last[r]    = first[r];
+            uint32_t n = rand() % 8;
+            for (uint32_t i = 0; i < n; i++) {
+                last[r] = rand();
+                rings[r]->wl_push(last[r]);
+            }
+        }
+
+        uint32_t pending = a.wl_pending_writes() + b.wl_pending_writes() + c.wl_pending_writes();
+        uint64_t writes  = sim_bus.write_cycles;
+        errors += wl_power_fail_service(); // nothing signalled yet
+        wl_power_fail_notify();
+        errors += !wl_power_fail_service();
+        misses += sim_bus.write_cycles - writes != pending;
+        errors += wl_power_fail_service(); // flag is cleared
+
+        uint32_t ptr;
+        for (uint32_t r = 0; r < 3; r++)
+            lost += stored(rings[r]->get_base_addr(), ptr) != last[r];
+        kept += stored(d.get_base_addr(), ptr) == first[3];
+    }
+
+    printf(
+        "power fail  %u failures signalled, %u pending estimates wrong, %u registered rings lost data, %u unregistered left alone: %u errors\n",
+        trials,
+        misses,
+        lost,
+        kept,
+        errors);
+    return errors + misses + lost + (trials - kept);
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t trials = argc > 1 ? strtoul(argv[1], nullptr, 0) : 1000;
+    uint32_t seed   = argc > 2 ? strtoul(argv[2], nullptr, 0) : 1;
+    srand(seed);
+
+    uint32_t failures = 0;
+    failures += check_shadow(trials);
+    failures += check_power_fail(trials);
+
+    printf("%s, %u failures\n", failures ? "FAIL" : "PASS", failures);
+    return failures ? 1 : 0;
+}
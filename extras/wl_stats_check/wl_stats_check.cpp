@@ -0,0 +1,113 @@
+/**
+ * @file wl_stats_check.cpp
+ * @brief Host check of wl_ring_stats() of WL_AT24CX against the records in a simulated AT24C256
+ *
+ * wipe: random pushes into a wiped ring, with or without group commit. records_written must count the
+ * pushes, wrapped must tell whether they went past the end of the ring, oldest_ptr must be the pointer
+ * of the oldest record in eeprom, staged records or not, and after a flush records_stored must be the
+ * number of records in eeprom.
+ * wrap: the pointer is set so the pushes that fill the ring run through pointer_max and restart from 0,
+ * then the same must hold against the records in eeprom.
+ *
+ * Build and run from repository root:
+ *   g++ -std=gnu++11 -O2 -Iextras/host -I. AT24CX.cpp extras/host/Wire.cpp \
+ *       extras/wl_stats_check/wl_stats_check.cpp -o wl_stats_check && ./wl_stats_check [trials] [seed]
+ */
+#include <Wire.h>
+#include <set>
+
+#include "WL_AT24CX.h"
+
+static const uint32_t num_of_data = 40;
+static const uint32_t pointer_max = 0xFFFFFFFF;
+
+typedef WL_AT24CX<uint32_t> ring_t;
+
+/**
+ * @brief find the oldest record in eeprom, the one whose previous pointer is not stored
+ *
+ * @param oldest pointer of the oldest record
+ * @param stored number of valid records
+ * @return true if the records form a single run of pointers
+ */
+static bool eeprom_oldest(ring_t &ring, uint32_t &oldest, uint32_t &stored)
+{
+    std::set<uint32_t> ptrs;
+    for (uint32_t taddr = 0; taddr < num_of_data; taddr++) {
+        ring_t::record_t record = ring.wl_peek(taddr);
+        if (ring.wl_isvalid(record))
+            ptrs.insert(record.ptr);
+    }
+
+    uint32_t runs = 0;
+    for (uint32_t ptr : ptrs) {
+        uint32_t prev = ptr == 0 ? pointer_max - 1 : ptr - 1;
+        if (ptrs.count(prev) == 0) {
+            oldest = ptr;
+            runs++;
+        }
+    }
+    stored = ptrs.size();
+    return runs == 1;
+}
+
+/**
+ * @brief compare the stats of ring against eeprom, staged records first, then after a flush
+ */
+static uint32_t compare(ring_t &ring, uint32_t pushes, uint32_t start)
+{
+    uint32_t errors = 0, oldest, stored;
+    wl_ring_stats_t stats = ring.wl_ring_stats();
+    errors += stats.records_written != ring.wl_get_ptr() || stats.wrapped != (pushes >= num_of_data);
+    if (eeprom_oldest(ring, oldest, stored))
+        errors += stats.oldest_ptr != oldest;
+
+    ring.flush();
+    stats = ring.wl_ring_stats();
+    if (!eeprom_oldest(ring, oldest, stored))
+        return errors + (pushes > 0);
+    errors += stats.oldest_ptr != oldest || stats.records_stored != stored;
+    errors += pushes < num_of_data && oldest != start;
+    return errors;
+}
+
+static uint32_t check(const char *name, bool wrap, uint32_t trials)
+{
+    uint32_t errors = 0, pushes = 0, wrapped = 0;
+    for (uint32_t t = 0; t < trials; t++) {
+        sim_eeprom[0].erase();
+        sim_bus.reset();
+        ring_t ring(0, 64, 0, num_of_data);
+        ring.wl_init3();
+        if (rand() % 2)
+            ring.wl_group_commit(1 + rand() % 8);
+
+        // pointers of a full ring run through pointer_max
+        uint32_t n     = wrap ? num_of_data + rand() % (2 * num_of_data) : rand() % (3 * num_of_data);
+        uint32_t start = wrap ? pointer_max - 1 - rand() % n : 0;
+        ring.wl_set_ptr(start);
+        for (uint32_t i = 0; i < n; i++)
+            ring.wl_push(rand());
+
+        wrapped += ring.wl_get_ptr() < start;
+        pushes += n;
+        errors += compare(ring, n, start);
+    }
+
+    printf("%-11s %u pushes, %u trials with the pointer wrapped: %u errors\n", name, pushes, wrapped, errors);
+    return errors;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t trials = argc > 1 ? strtoul(argv[1], nullptr, 0) : 1000;
+    uint32_t seed   = argc > 2 ? strtoul(argv[2], nullptr, 0) : 1;
+    srand(seed);
+
+    uint32_t failures = 0;
+    failures += check("wipe", false, trials);
+    failures += check("wrap", true, trials);
+
+    printf("%s, %u failures\n", failures ? "FAIL" : "PASS", failures);
+    return failures ? 1 : 0;
+}
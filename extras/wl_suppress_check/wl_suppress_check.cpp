@@ -0,0 +1,155 @@
+/**
+ * @file wl_suppress_check.cpp
+ * @brief Host check of the write-suppression policies of WL_AT24CX on a simulated AT24C256
+ *
+ * held: identical and interval together. 1 is pushed, then 2 within the interval, then 2 every 50 ms
+ * for 5 s. The held-back 2 must reach eeprom although every later push of 2 is identical.
+ * counters: a fixed sequence with identical, deadband and interval on, every counter and the number
+ * of records written must match the policy.
+ * random: all three policies on, random values and gaps. After every push wl_get_last_data() must be
+ * within the deadband of the push, at the end wl_service() must leave that value in eeprom, and the
+ * counters must add up with the records written.
+ *
+ * Build and run from repository root:
+ *   g++ -std=gnu++11 -O2 -Iextras/host -I. AT24CX.cpp extras/host/Wire.cpp \
+ *       extras/wl_suppress_check/wl_suppress_check.cpp -o wl_suppress_check && ./wl_suppress_check [trials] [seed]
+ */
+#include <Wire.h>
+#include <cmath>
+
+#include "WL_AT24CX.h"
+
+static const uint32_t num_of_data = 32;
+
+template <class data_t>
+static data_t stored()
+{
+    WL_AT24CX<data_t> reboot(0, 64, 0, num_of_data);
+    reboot.wl_init3();
+    return reboot.wl_get_last_data();
+}
+
+static uint32_t check_held()
+{
+    sim_eeprom[0].erase();
+    sim_bus.reset();
+    WL_AT24CX<uint32_t> ring(0, 64, 0, num_of_data);
+    ring.wl_init3();
+    ring.wl_suppress_identical(true);
+    ring.wl_suppress_interval(1000);
+
+    ring.wl_push(1);
+    delay(10);
+    ring.wl_push(2);
+    for (uint32_t t = 0; t < 5000; t += 50) {
+        delay(50);
+        ring.wl_push(2);
+    }
+
+    uint32_t last = stored<uint32_t>();
+    wl_suppress_stats_t counts = ring.wl_suppress_stats();
+    printf(
+        "held      last data %u, eeprom %u, identical %u, interval %u\n",
+        ring.wl_get_last_data(),
+        last,
+        counts.identical,
+        counts.interval);
+    return (last != 2) + (ring.wl_get_last_data() != 2) + (counts.interval != 1);
+}
+
+static uint32_t check_counters()
+{
+    sim_eeprom[0].erase();
+    sim_bus.reset();
+    WL_AT24CX<float> ring(0, 64, 0, num_of_data);
+    ring.wl_init3();
+    ring.wl_suppress_identical(true);
+    ring.wl_suppress_deadband(0.5f);
+    ring.wl_suppress_interval(100);
+
+    ring.wl_push(10.0f); // written
+    ring.wl_push(10.0f); // identical
+    ring.wl_push(10.2f); // deadband
+    delay(200);
+    ring.wl_push(12.0f); // written
+    delay(10);
+    ring.wl_push(14.0f); // interval, held back
+    delay(10);
+    ring.wl_push(14.0f); // identical, held value not due yet
+    delay(150);
+    ring.wl_push(14.1f); // deadband, held value due and written
+    delay(200);
+    ring.wl_push(16.0f); // written
+
+    wl_suppress_stats_t counts = ring.wl_suppress_stats();
+    uint32_t records           = ring.wl_get_ptr();
+    float last                 = stored<float>();
+    printf(
+        "counters  identical %u, deadband %u, interval %u, %u records, eeprom %.1f\n",
+        counts.identical,
+        counts.deadband,
+        counts.interval,
+        records,
+        last);
+    return (counts.identical != 2) + (counts.deadband != 2) + (counts.interval != 1) + (records != 4) + (last != 16.0f);
+}
+
+static uint32_t check_random(uint32_t trials)
+{
+    const float deadband     = 0.5f;
+    const uint32_t interval  = 100;
+    uint32_t far = 0, lost = 0, unbalanced = 0;
+
+    for (uint32_t t = 0; t < trials; t++) {
+        sim_eeprom[0].erase();
+        sim_bus.reset();
+        WL_AT24CX<float> ring(0, 64, 0, num_of_data);
+        ring.wl_init3();
+        ring.wl_suppress_identical(true);
+        ring.wl_suppress_deadband(deadband);
+        ring.wl_suppress_interval(interval);
+
+        float value     = 0;
+        uint32_t pushes = 1 + rand() % 60;
+        for (uint32_t i = 0; i < pushes; i++) {
+            int step = rand() % 4; // repeat, small step, large step
+            if (step == 1)
+                value += (rand() % 100) / 250.0f;
+            else if (step >= 2)
+                value += (rand() % 100) / 10.0f - 5;
+            delay(rand() % 200);
+            ring.wl_push(value);
+            far += std::fabs((double)ring.wl_get_last_data() - value) >= deadband;
+            if (rand() % 8 == 0)
+                ring.wl_service();
+        }
+
+        delay(interval);
+        ring.wl_service();
+        lost += stored<float>() != ring.wl_get_last_data();
+
+        // every push is suppressed, held back or written, a held-back push is written at most once
+        wl_suppress_stats_t counts = ring.wl_suppress_stats();
+        uint32_t records           = ring.wl_get_ptr();
+        unbalanced += records + counts.identical + counts.deadband + counts.interval < pushes;
+        unbalanced += records + counts.identical + counts.deadband > pushes;
+    }
+
+    printf("random    %u trials: %u pushes off by a deadband, %u lost after service, %u counter mismatches\n", trials, far, lost, unbalanced);
+    return far + lost + unbalanced;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t trials = argc > 1 ? strtoul(argv[1], nullptr, 0) : 3000;
+    uint32_t seed   = argc > 2 ? strtoul(argv[2], nullptr, 0) : 1;
+    srand(seed);
+
+    uint32_t failures = 0;
+    failures += check_held();
+    failures += check_counters();
+    failures += check_random(trials);
+
+    printf("%s, %u failures\n", failures ? "FAIL" : "PASS", failures);
+    return failures ? 1 : 0;
+}
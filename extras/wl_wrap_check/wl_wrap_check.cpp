@@ -0,0 +1,83 @@
+/**
+ * @file wl_wrap_check.cpp
+ * @brief Host check of WL_AT24CX pointer wraparound on a simulated AT24C256
+ *
+ * Each ring starts a few laps before the 2^32 - 1 pointer wrap using wl_set_ptr(), then pushes
+ * through the wrap. After every push a fresh object runs each init algorithm and must recover the
+ * last value and the next pointer, and wl_history must read back across the wrap.
+ *
+ * Build and run from repository root:
+ *   g++ -std=gnu++11 -O2 -Iextras/host -I. AT24CX.cpp extras/host/Wire.cpp \
+ *       extras/wl_wrap_check/wl_wrap_check.cpp -o wl_wrap_check && ./wl_wrap_check
+ */
+#include <Wire.h>
+
+#include "WL_AT24CX.h"
+
+static const uint32_t pointer_max = std::numeric_limits<uint32_t>::max();
+
+template <class engine_t>
+static uint32_t check(const char *name, uint32_t num_of_data, uint32_t laps)
+{
+    uint32_t failures = 0;
+    uint32_t start    = pointer_max - laps * num_of_data - 1;
+
+    sim_eeprom[0].erase();
+    WL_AT24CX<uint32_t, engine_t> eeprom(0, 64, 0, num_of_data);
+    eeprom.wl_init2();
+    eeprom.wl_set_ptr(start);
+
+    uint32_t ptr = start;
+    for (uint32_t i = 0; i < 2 * laps * num_of_data; i++) {
+        eeprom.wl_push(i);
+        ptr = (ptr + 1 == pointer_max) ? 0 : ptr + 1;
+
+        for (int algorithm = 1; algorithm <= 3; algorithm++) {
+            WL_AT24CX<uint32_t, engine_t> reboot(0, 64, 0, num_of_data);
+            if (algorithm == 1)
+                reboot.wl_init();
+            else if (algorithm == 2)
+                reboot.wl_init2();
+            else
+                reboot.wl_init3();
+
+            if (reboot.wl_get_last_data() != i || reboot.wl_get_ptr() != ptr) {
+                printf(
+                    "%s N=%u push %u: wl_init%d got data %u ptr %u, expected %u ptr %u\n",
+                    name,
+                    num_of_data,
+                    i,
+                    algorithm,
+                    reboot.wl_get_last_data(),
+                    reboot.wl_get_ptr(),
+                    i,
+                    ptr);
+                failures++;
+            }
+        }
+
+        uint32_t history[64];
+        uint32_t expected = min(i + 1, num_of_data);
+        uint32_t n        = eeprom.wl_history(history, 64);
+        if (n != min<uint32_t>(expected, 64) || history[n - 1] != i + 1 - n) {
+            printf("%s N=%u push %u: wl_history read %u records\n", name, num_of_data, i, n);
+            failures++;
+        }
+    }
+
+    return failures;
+}
+
+int main()
+{
+    uint32_t failures = 0;
+    const uint32_t sizes[] = {1, 2, 3, 7, 16, 33};
+
+    for (uint32_t num_of_data : sizes) {
+        failures += check<wl_engine_ptr>("ptr", num_of_data, 3);
+        failures += check<wl_engine_ptr_crc16>("ptr_crc16", num_of_data, 3);
+    }
+
+    printf("%s, %u failures\n", failures ? "FAIL" : "PASS", failures);
+    return failures ? 1 : 0;
+}